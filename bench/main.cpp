@@ -0,0 +1,394 @@
+#include "acceptance.hpp"
+#include "config.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+#include "fm_refine.hpp"
+#include "indexed_blocks.hpp"
+#include "multilevel.hpp"
+#include "sim_anneal.hpp"
+#include "starting_partition.hpp"
+#include "tempering.hpp"
+#include "worker_pool.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace {
+constexpr int seed = 42;
+
+// Minimum time and number of calls over which a kernel is timed.
+constexpr duration<double> min_kernel_time{0.2};
+constexpr int min_kernel_calls = 3;
+
+// Number of SA passes timed per testcase.
+constexpr int64_t npasses = 2'000'000;
+
+// Interval between samples of the best cost of SA in the macro mode.
+constexpr steady_clock::duration sample_interval = std::chrono::seconds(1);
+
+const char* const usage =
+    "Usage: pa2_bench [micro [TESTCASE_DIR]]\n"
+    "       pa2_bench macro CSV_FILE [SECONDS [NSEEDS [TESTCASE_DIR]]]\n";
+
+// Builds `nblocks` blocks of `block_size` unit-area cells each.
+vector<Block> make_blocks(size_t nblocks, size_t block_size) {
+  vector<Block> blocks(nblocks);
+  for (size_t i = 0; i < nblocks * block_size; i += 1) {
+    blocks[i % nblocks].cells.push_back(i);
+    blocks[i % nblocks].area += 1;
+  }
+  return blocks;
+}
+
+// Measures moves per second of random cells to random blocks, for blocks of
+// growing size.  With `IndexedBlocks` the rate should not depend on the size.
+void bench_cell_moves() {
+  constexpr size_t nblocks = 4;
+  constexpr int64_t nmoves = 2'000'000;
+
+  fmt::print("{:>12}  {:>16}\n", "BlockSize", "MovesPerSec");
+  for (size_t block_size = 1'000; block_size <= 1'000'000; block_size *= 10) {
+    const size_t ncells = nblocks * block_size;
+    IndexedBlocks blocks(make_blocks(nblocks, block_size), ncells);
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<CellId> cell_id_gen(0, ncells - 1);
+    std::uniform_int_distribution<BlockId> block_id_gen(0, nblocks - 1);
+
+    const auto begin_time = steady_clock::now();
+    for (int64_t i = 0; i < nmoves; i += 1) {
+      const CellId cell_id = cell_id_gen(gen);
+      const BlockId to_block_id = block_id_gen(gen);
+      if (blocks.block_of(cell_id) != to_block_id) {
+        blocks.move(cell_id, to_block_id, 1);
+      }
+    }
+    const std::chrono::duration<double> elapsed =
+        steady_clock::now() - begin_time;
+
+    verify_blocks(blocks.into_blocks(), ncells);
+    fmt::print("{:>12}  {:>16.0f}\n", block_size,
+               static_cast<double>(nmoves) / elapsed.count());
+  }
+}
+
+// Measures proposals per second of the acceptance kernels on random deltas,
+// and counts decisions differing from evaluating `std::exp` on every proposal.
+// The temperature either cools on every accepted move as in SA, or stays fixed
+// as in tempering replicas.
+void bench_acceptance() {
+  constexpr size_t nproposals = 4'000'000;
+
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<Cost> delta_gen(-8, 40);
+  std::uniform_real_distribution<double> zero_one_gen(0.0, 1.0);
+  vector<Cost> deltas(nproposals);
+  vector<double> draws(nproposals);
+  for (size_t i = 0; i < nproposals; i += 1) {
+    deltas[i] = delta_gen(gen);
+    draws[i] = zero_one_gen(gen);
+  }
+
+  // Runs `accept` over all proposals, returning decisions and the rate
+  const auto run = [&](auto&& accept, double cooling_factor) {
+    vector<uint8_t> decisions(nproposals);
+    double temp = config::default_init_temp;
+    const bool is_temp_fixed = cooling_factor == 1.0;
+
+    const auto begin_time = steady_clock::now();
+    for (size_t i = 0; i < nproposals; i += 1) {
+      const bool is_accepted =
+          accept(deltas[i], temp, is_temp_fixed, draws[i]);
+      decisions[i] = is_accepted;
+      if (is_accepted) {
+        temp = std::max(temp * cooling_factor, config::temp_limit);
+      }
+    }
+    const std::chrono::duration<double> elapsed =
+        steady_clock::now() - begin_time;
+
+    return std::pair{std::move(decisions),
+                     static_cast<double>(nproposals) / elapsed.count()};
+  };
+
+  const std::pair<const char*, double> schedules[] = {
+      {"cooling", 0.999999},
+      {"fixed", 1.0},
+  };
+  const std::pair<const char*, AcceptanceMode> modes[] = {
+      {"exact", AcceptanceMode::Exact},
+      {"approx", AcceptanceMode::Approximate},
+  };
+
+  fmt::print("{:>12}  {:>12}  {:>16}  {:>12}\n", "Schedule", "Kernel",
+             "ProposalsPerSec", "Mismatches");
+  for (const auto& [schedule, cooling_factor] : schedules) {
+    const auto [reference, reference_rate] = run(
+        [](Cost cost_delta, double temp, bool /*is_temp_fixed*/, double u) {
+          return cost_delta < 0 ||
+                 u <= std::exp(static_cast<double>(-cost_delta) / temp);
+        },
+        cooling_factor);
+    fmt::print("{:>12}  {:>12}  {:>16.0f}  {:>12}\n", schedule, "std::exp",
+               reference_rate, 0);
+
+    for (const auto& [name, mode] : modes) {
+      Acceptance acceptance{mode};
+      const auto [decisions, rate] = run(acceptance, cooling_factor);
+      const auto nmismatches =
+          std::inner_product(decisions.begin(), decisions.end(),
+                             reference.begin(), int64_t{0}, std::plus<>{},
+                             std::not_equal_to<>{});
+      fmt::print("{:>12}  {:>12}  {:>16.0f}  {:>12}\n", schedule, name, rate,
+                 nmismatches);
+    }
+  }
+}
+
+// A testcase and its name relative to the testcase directory.
+struct Testcase {
+  string name;
+  string path;
+};
+
+// Finds the `.in` files in the `basic` and `advanced` subdirectories of
+// `dir`.
+vector<Testcase> find_testcases(const string& dir) {
+  const string extension = ".in";
+
+  vector<Testcase> testcases;
+  for (const char* subdir : {"basic", "advanced"}) {
+    const string path = fmt::format("{}/{}", dir, subdir);
+    DIR* entries = ::opendir(path.c_str());
+    if (entries == nullptr) {
+      continue;
+    }
+    vector<Testcase> found;
+    while (const dirent* entry = ::readdir(entries)) {
+      const string filename = entry->d_name;
+      if (filename.size() > extension.size() &&
+          filename.compare(filename.size() - extension.size(),
+                           extension.size(), extension) == 0) {
+        const string stem =
+            filename.substr(0, filename.size() - extension.size());
+        found.push_back(Testcase{fmt::format("{}/{}", subdir, stem),
+                                 fmt::format("{}/{}", path, filename)});
+      }
+    }
+    ::closedir(entries);
+    std::sort(found.begin(), found.end(),
+              [](const auto& a, const auto& b) { return a.name < b.name; });
+    testcases.insert(testcases.end(), found.begin(), found.end());
+  }
+  if (testcases.empty()) {
+    throw std::runtime_error(
+        fmt::format("No testcases found in {}/{{basic,advanced}}", dir));
+  }
+  return testcases;
+}
+
+// Gets the mean seconds per call of `f`, called repeatedly for at least
+// `min_kernel_time`.
+template <typename F>
+double time_per_call(F&& f) {
+  int ncalls = 0;
+  const auto begin_time = steady_clock::now();
+  duration<double> elapsed{0};
+  while (ncalls < min_kernel_calls || elapsed < min_kernel_time) {
+    f();
+    ncalls += 1;
+    elapsed = steady_clock::now() - begin_time;
+  }
+  return elapsed.count() / ncalls;
+}
+
+// Measures the kernels of a run on each testcase: reading the input, finding
+// the starting partition and its cost, and SA passes.  Results are printed
+// after all testcases, since the kernels print progress of their own.
+void bench_kernels(const string& dir) {
+  struct Row {
+    string testcase;
+    const char* kernel;
+    double us_per_call;
+    double calls_per_sec;
+  };
+  vector<Row> rows;
+
+  const size_t nthreads = std::max(std::thread::hardware_concurrency(), 1U);
+  WorkerPool pool{nthreads};
+  const string parallel_find_cost = fmt::format("find_cost/{}", nthreads);
+
+  for (const Testcase& testcase : find_testcases(dir)) {
+    const auto add_row = [&](const char* kernel, double secs) {
+      rows.push_back(Row{testcase.name, kernel, secs * 1e6, 1.0 / secs});
+    };
+
+    InputData inputs;
+    add_row("read", time_per_call([&] {
+              inputs = InputData::read_from(testcase.path);
+            }));
+
+    vector<Block> blocks;
+    add_row("find_starting_partition",
+            time_per_call([&] { blocks = find_starting_partition(inputs); }));
+
+    Cost cost = 0;
+    add_row("find_cost",
+            time_per_call([&] { cost = find_cost(blocks, inputs); }));
+    add_row(parallel_find_cost.c_str(),
+            time_per_call([&] { cost = find_cost(blocks, inputs, pool); }));
+
+    Budget budget;
+    budget.max_moves = std::numeric_limits<int64_t>::max();
+    SimAnneal sim_anneal{blocks, inputs, cost, seed, steady_clock::now(),
+                         budget};
+    const auto begin_time = steady_clock::now();
+    for (int64_t i = 0; i < npasses; i += 1) {
+      sim_anneal.perform_pass(inputs);
+    }
+    const duration<double> elapsed = steady_clock::now() - begin_time;
+    add_row("perform_pass", elapsed.count() / npasses);
+  }
+
+  fmt::print("\n{:>24}  {:>24}  {:>12}  {:>16}\n", "Testcase", "Kernel",
+             "UsPerCall", "CallsPerSec");
+  for (const Row& row : rows) {
+    fmt::print("{:>24}  {:>24}  {:>12.3f}  {:>16.0f}\n", row.testcase,
+               row.kernel, row.us_per_call, row.calls_per_sec);
+  }
+}
+
+// Records the best cost over wall time of each engine on each testcase to
+// `csv_path`, with budgets of `secs` seconds and seeds 1 to `nseeds`.  The
+// best cost of SA is sampled every `sample_interval`, while the other
+// engines give one sample at their end.  FM does not depend on the seed, so
+// it runs once per testcase and is recorded with seed 0.
+void bench_quality(const string& csv_path, int64_t secs, int64_t nseeds,
+                   const string& dir) {
+  std::ofstream csv(csv_path);
+  csv.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+  csv << "testcase,engine,seed,seconds,best_cost\n";
+
+  Config config{};
+  config.budget.time_limit = std::chrono::seconds(secs);
+
+  for (const Testcase& testcase : find_testcases(dir)) {
+    const InputData inputs = InputData::read_from(testcase.path);
+    const vector<Block> blocks = find_starting_partition(inputs);
+    const Cost init_cost = find_cost(blocks, inputs);
+    const auto record = [&](const char* engine, uint64_t seed,
+                            steady_clock::time_point begin_time,
+                            Cost best_cost) {
+      const duration<double> elapsed = steady_clock::now() - begin_time;
+      csv << fmt::format("{},{},{},{:.3f},{}\n", testcase.name, engine, seed,
+                         elapsed.count(), best_cost);
+    };
+
+    {
+      const auto begin_time = steady_clock::now();
+      const auto result = perform_fm_refinement(blocks, inputs, init_cost,
+                                                config.budget.time_limit);
+      record("fm", 0, begin_time, find_cost(result, inputs));
+    }
+
+    for (uint64_t seed = 1; seed <= static_cast<uint64_t>(nseeds);
+         seed += 1) {
+      config.seed = seed;
+
+      // SA, sampled along the way
+      {
+        const auto begin_time = steady_clock::now();
+        SimAnneal sim_anneal{blocks,        inputs, init_cost,
+                             seed,          begin_time,
+                             config.budget, config::default_init_temp,
+                             config.anneal};
+        record("anneal", seed, begin_time, init_cost);
+        const auto end_time = begin_time + config.budget.time_limit;
+        auto next_sample_time = begin_time + sample_interval;
+        while (sim_anneal.should_terminate() == false) {
+          const auto res = sim_anneal.perform_pass(inputs);
+          if (res.time >= next_sample_time && next_sample_time < end_time) {
+            record("anneal", seed, begin_time, sim_anneal.get_best_cost());
+            next_sample_time += sample_interval;
+          }
+        }
+        record("anneal", seed, begin_time, sim_anneal.get_best_cost());
+      }
+
+      // The other engines, sampled at their end
+      {
+        const auto begin_time = steady_clock::now();
+        const auto result =
+            perform_tempering_partition(blocks, inputs, init_cost, config);
+        record("tempering", seed, begin_time, find_cost(result, inputs));
+      }
+      {
+        const auto begin_time = steady_clock::now();
+        const auto result = perform_multilevel_partition(inputs, config);
+        record("multilevel", seed, begin_time, find_cost(result, inputs));
+      }
+      csv.flush();
+    }
+  }
+}
+
+// Parses a positive integer argument.
+int64_t parse_positive(const char* arg) {
+  const int64_t value = std::stoll(arg);
+  if (value <= 0) {
+    throw std::runtime_error(
+        fmt::format("Expects a positive integer, got '{}'", arg));
+  }
+  return value;
+}
+}  // namespace
+
+int main(int argc, char** argv) try {
+  const vector<string> args(argv + 1, argv + argc);  // NOLINT
+  const string mode = args.empty() ? "micro" : args[0];
+
+  if (mode == "micro") {
+    bench_cell_moves();
+    fmt::print("\n");
+    bench_acceptance();
+    bench_kernels(args.size() > 1 ? args[1] : "testcases");
+    return 0;
+  }
+
+  if (mode == "macro" && args.size() >= 2) {
+    bench_quality(args[1],
+                  args.size() > 2 ? parse_positive(args[2].c_str()) : 10,
+                  args.size() > 3 ? parse_positive(args[3].c_str()) : 1,
+                  args.size() > 4 ? args[4] : "testcases");
+    return 0;
+  }
+
+  fmt::print(stderr, "{}", usage);
+  return 1;
+} catch (const std::exception& e) {
+  fmt::print(stderr, "Exception caught at main(): {}\n", e.what());
+  return 1;
+}
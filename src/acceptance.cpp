@@ -0,0 +1,12 @@
+#include "acceptance.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+void Acceptance::rebuild(double temp) {
+  table_temp = temp;
+  for (size_t cost_delta = 0; cost_delta < table_size; cost_delta += 1) {
+    approx_table[cost_delta] =
+        std::exp(-static_cast<double>(cost_delta) / temp);
+  }
+}
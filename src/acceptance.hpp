@@ -0,0 +1,78 @@
+#ifndef ACCEPTANCE_HPP_
+#define ACCEPTANCE_HPP_
+
+#include "config.hpp"
+#include "cost.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Metropolis acceptance test of SA, which accepts a move of `cost_delta` at
+// temperature `temp` if the uniform draw `u` in [0, 1) is at most
+// exp(-cost_delta / temp).
+//
+// Moves that do not raise the cost are accepted without evaluating `std::exp`.
+// Uphill moves of small deltas may take their probabilities from a table:
+// - In exact mode, the table is only used at a fixed temperature, as in
+//   tempering replicas, since a cooling temperature changes on every accepted
+//   move and the entries would rarely be reused.  Each entry remembers the
+//   temperature it was computed at and is recomputed when the temperature
+//   differs, so that decisions are the same as evaluating `std::exp` on every
+//   proposal.
+// - In approximate mode, the whole table is built for one temperature, and is
+//   rebuilt only when the temperature drifts from it by more than
+//   `config::acceptance_temp_tolerance`, relatively.
+class Acceptance {
+ public:
+  explicit Acceptance(AcceptanceMode mode) : mode(mode) {}
+
+  bool operator()(Cost cost_delta, double temp, bool is_temp_fixed, double u) {
+    if (cost_delta <= 0) {
+      return true;
+    }
+    if (cost_delta >= static_cast<Cost>(table_size) ||
+        (mode == AcceptanceMode::Exact && is_temp_fixed == false)) {
+      return u <= std::exp(static_cast<double>(-cost_delta) / temp);
+    }
+
+    if (mode == AcceptanceMode::Exact) {
+      Entry& entry = exact_table[cost_delta];
+      if (entry.temp != temp) {
+        entry.temp = temp;
+        entry.probability = std::exp(static_cast<double>(-cost_delta) / temp);
+      }
+      return u <= entry.probability;
+    }
+
+    if (std::abs(temp - table_temp) >
+        config::acceptance_temp_tolerance * table_temp) {
+      rebuild(temp);
+    }
+    return u <= approx_table[cost_delta];
+  }
+
+ private:
+  // Deltas below this are looked up, while larger ones are rare enough to be
+  // evaluated directly
+  static constexpr size_t table_size = 256;
+
+  struct Entry {
+    double temp = 0.0;
+    double probability = 0.0;
+  };
+
+  // Rebuilds the approximate table for `temp`.
+  void rebuild(double temp);
+
+  AcceptanceMode mode;
+
+  // Delta -> probability at `Entry::temp`
+  std::array<Entry, table_size> exact_table{};
+
+  // Delta -> probability at `table_temp`
+  std::array<double, table_size> approx_table{};
+  double table_temp = 0.0;
+};
+
+#endif  // ACCEPTANCE_HPP_
@@ -0,0 +1,207 @@
+#include "audit.hpp"
+#include "bindings.hpp"
+#include "data.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+using std::string;
+using std::vector;
+
+namespace {
+Cost sqr(Cost x) { return x * x; }
+}  // namespace
+
+Auditor::Auditor(const InputData& inputs, vector<BlockId> block_of_cell,
+                 Cost init_cost)
+    : inputs(inputs),
+      verified_block_of_cell(std::move(block_of_cell)),
+      verified_cost(init_cost) {
+  worker = std::thread([this] { work(); });
+}
+
+Auditor::~Auditor() {
+  {
+    std::lock_guard lock{mutex};
+    is_stopping = true;
+  }
+  cv.notify_all();
+  worker.join();
+}
+
+bool Auditor::is_idle() {
+  std::lock_guard lock{mutex};
+  return pending.has_value() == false;
+}
+
+void Auditor::submit(AuditSnapshot snapshot) {
+  {
+    std::lock_guard lock{mutex};
+    pending = std::move(snapshot);
+  }
+  cv.notify_all();
+}
+
+void Auditor::finish() {
+  std::unique_lock lock{mutex};
+  cv.wait(lock, [this] { return pending.has_value() == false; });
+  if (has_failed()) {
+    throw std::runtime_error(failure);
+  }
+  fmt::print("Audited {} snapshots up to move {}\n", nchecked,
+             verified_nmoves);
+}
+
+void Auditor::work() {
+  std::unique_lock lock{mutex};
+  while (true) {
+    cv.wait(lock, [this] { return is_stopping || pending.has_value(); });
+    if (pending.has_value() == false) {
+      return;
+    }
+
+    // Check without holding the lock, so that the chain can poll
+    // `is_idle`.  The snapshot stays in place until checked.
+    lock.unlock();
+    const AuditSnapshot& snapshot = *pending;
+    if (has_failed() == false) {
+      if (auto divergence = check(snapshot)) {
+        failure = fmt::format("Audit failed at move {}: {}; {}",
+                              snapshot.nmoves, *divergence, locate(snapshot));
+        fmt::print(stderr, "{}\n", failure);
+        is_failed.store(true, std::memory_order_relaxed);
+      } else {
+        verified_block_of_cell = snapshot.block_of_cell;
+        verified_cost = snapshot.cost;
+        verified_nmoves = snapshot.nmoves;
+        nchecked += 1;
+      }
+    }
+    lock.lock();
+
+    pending.reset();
+    cv.notify_all();
+  }
+}
+
+std::optional<string> Auditor::check(const AuditSnapshot& snapshot) const {
+  const size_t nblocks = snapshot.block_areas.size();
+
+  // Blocks
+  vector<size_t> areas(nblocks, 0);
+  vector<size_t> sizes(nblocks, 0);
+  for (CellId cell_id = 0; cell_id < inputs.ncells; cell_id += 1) {
+    areas[snapshot.block_of_cell[cell_id]] += inputs.cell_areas[cell_id];
+    sizes[snapshot.block_of_cell[cell_id]] += 1;
+  }
+  for (BlockId block_id = 0; block_id < nblocks; block_id += 1) {
+    if (areas[block_id] != snapshot.block_areas[block_id]) {
+      return fmt::format("area of block {} is {}, expected {}", block_id,
+                         snapshot.block_areas[block_id], areas[block_id]);
+    }
+    if (sizes[block_id] != snapshot.block_sizes[block_id]) {
+      return fmt::format("block {} has {} cells, expected {}", block_id,
+                         snapshot.block_sizes[block_id], sizes[block_id]);
+    }
+    if (areas[block_id] > inputs.max_block_area) {
+      return fmt::format("area of block {} is {}, above the limit {}",
+                         block_id, areas[block_id], inputs.max_block_area);
+    }
+  }
+
+  // Nets
+  vector<uint32_t> counts(nblocks, 0);
+  vector<BlockId> spanned;
+  Cost cost = 0;
+  for (NetId net_id = 0; net_id < inputs.nnets; net_id += 1) {
+    const Net net = inputs.nets[net_id];
+    spanned.clear();
+    for (const CellId cell_id : net) {
+      const BlockId block_id = snapshot.block_of_cell[cell_id];
+      if (counts[block_id] == 0) {
+        spanned.push_back(block_id);
+      }
+      counts[block_id] += 1;
+    }
+
+    const Cost span = static_cast<Cost>(spanned.size());
+    if (span != snapshot.span_of_net[net_id]) {
+      return fmt::format("span of net {} is {}, expected {}", net_id,
+                         snapshot.span_of_net[net_id], span);
+    }
+    for (const BlockId block_id : spanned) {
+      const uint32_t bound = snapshot.bindings.get(net_id, block_id);
+      if (bound != counts[block_id]) {
+        return fmt::format("net {} has {} cells in block {}, expected {}",
+                           net_id, bound, block_id, counts[block_id]);
+      }
+      counts[block_id] = 0;
+    }
+    size_t nbound = 0;
+    snapshot.bindings.for_each_block(
+        net_id, [&](BlockId, uint32_t count) { nbound += count; });
+    if (nbound != net.size()) {
+      return fmt::format("net {} has {} cells in blocks, expected {}",
+                         net_id, nbound, net.size());
+    }
+
+    cost += sqr(span - 1);
+  }
+
+  if (cost != snapshot.cost) {
+    return fmt::format("cost is {}, expected {}", snapshot.cost, cost);
+  }
+  return std::nullopt;
+}
+
+string Auditor::locate(const AuditSnapshot& snapshot) const {
+  vector<BlockId> block_of_cell = verified_block_of_cell;
+  vector<uint64_t> block_stamp(snapshot.block_areas.size(), 0);
+  uint64_t stamp = 0;
+  const auto cost_of_net = [&](NetId net_id) {
+    stamp += 1;
+    Cost span = 0;
+    for (const CellId cell_id : inputs.nets[net_id]) {
+      if (block_stamp[block_of_cell[cell_id]] != stamp) {
+        block_stamp[block_of_cell[cell_id]] = stamp;
+        span += 1;
+      }
+    }
+    return sqr(span - 1);
+  };
+
+  Cost cost = verified_cost;
+  int64_t nmoves = verified_nmoves;
+  for (const AuditedStep& step : snapshot.steps) {
+    if (block_of_cell[step.cell_id] != step.from_block_id) {
+      return fmt::format("move {} takes cell {} from block {}, but it is in "
+                         "block {}",
+                         nmoves + 1, step.cell_id, step.from_block_id,
+                         block_of_cell[step.cell_id]);
+    }
+    for (const NetId net_id : inputs.cells[step.cell_id]) {
+      cost -= cost_of_net(net_id);
+    }
+    block_of_cell[step.cell_id] = step.to_block_id;
+    for (const NetId net_id : inputs.cells[step.cell_id]) {
+      cost += cost_of_net(net_id);
+    }
+
+    if (step.ends_move) {
+      nmoves += 1;
+      if (cost != step.cost) {
+        return fmt::format(
+            "move {} of cell {} from block {} to {} leaves cost {}, expected "
+            "{}",
+            nmoves, step.cell_id, step.from_block_id, step.to_block_id,
+            step.cost, cost);
+      }
+    }
+  }
+  return fmt::format("no move since move {} leaves a wrong cost",
+                     verified_nmoves);
+}
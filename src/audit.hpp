@@ -0,0 +1,106 @@
+#ifndef AUDIT_HPP_
+#define AUDIT_HPP_
+
+#include "bindings.hpp"
+#include "data.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Cost = std::int64_t;
+
+// Cell moved by an accepted move of a SA chain.
+struct AuditedStep {
+  CellId cell_id;
+  BlockId from_block_id;
+  BlockId to_block_id;
+
+  // Whether the step is the last one of its move
+  bool ends_move;
+
+  // Cost of the chain after the move, if `ends_move`
+  Cost cost;
+};
+
+// Copy of the incremental state of a SA chain.
+struct AuditSnapshot {
+  // Number of accepted moves so far
+  int64_t nmoves = 0;
+
+  Cost cost = 0;
+  std::vector<BlockId> block_of_cell;
+  std::vector<size_t> block_areas;
+  std::vector<size_t> block_sizes;
+  std::vector<Cost> span_of_net;
+  Bindings bindings;
+
+  // Steps of the moves since the previous snapshot
+  std::vector<AuditedStep> steps;
+};
+
+// Checks snapshots of the incremental state of a SA chain against the state
+// recomputed from scratch, on a background thread.
+//
+// Upon the first divergence, the steps since the last consistent snapshot are
+// replayed to find the first move leaving a wrong cost, the failure is
+// printed, and no further snapshots are checked.
+class Auditor {
+ public:
+  // Starts the background thread.  `block_of_cell` and `init_cost` are the
+  // starting state of the chain, which is trusted.
+  Auditor(const InputData& inputs, std::vector<BlockId> block_of_cell,
+          Cost init_cost);
+  ~Auditor();
+
+  Auditor(const Auditor&) = delete;
+  Auditor& operator=(const Auditor&) = delete;
+
+  // Whether the previous snapshot has been checked.
+  bool is_idle();
+
+  // Hands over a snapshot to check.  The auditor must be idle.
+  void submit(AuditSnapshot snapshot);
+
+  // Whether a divergence has been found.
+  bool has_failed() const { return is_failed.load(std::memory_order_relaxed); }
+
+  // Waits for the pending snapshot to be checked, and throws if a divergence
+  // has been found.
+  void finish();
+
+ private:
+  void work();
+
+  // Gets the first divergence of `snapshot` from the recomputed state.
+  std::optional<std::string> check(const AuditSnapshot& snapshot) const;
+
+  // Gets the first step since the last consistent snapshot whose move leaves
+  // a wrong cost.
+  std::string locate(const AuditSnapshot& snapshot) const;
+
+  const InputData& inputs;
+
+  // Last consistent state
+  std::vector<BlockId> verified_block_of_cell;
+  Cost verified_cost;
+  int64_t verified_nmoves = 0;
+  size_t nchecked = 0;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::optional<AuditSnapshot> pending;
+  bool is_stopping = false;
+
+  std::atomic<bool> is_failed = false;
+  std::string failure;
+
+  std::thread worker;
+};
+
+#endif  // AUDIT_HPP_
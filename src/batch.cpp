@@ -0,0 +1,284 @@
+#include "batch.hpp"
+#include "config.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+#include "fm_refine.hpp"
+#include "mapped_file.hpp"
+#include "multilevel.hpp"
+#include "partition.hpp"
+#include "starting_partition.hpp"
+#include "tempering.hpp"
+#include "worker_pool.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+#include <range/v3/all.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ranges::views::enumerate;
+using std::string;
+using std::vector;
+
+using std::chrono::steady_clock;
+
+namespace {
+void debug_print_inputs(const InputData& inputs, const vector<Block>& blocks) {
+  inputs.debug_print();
+  for (const auto& [i, block] : blocks | enumerate) {
+    fmt::print("Group {} (area = {}) contains cells: {}\n", i, block.area,
+               fmt::join(block.cells, ", "));
+  }
+
+  fmt::print("Max degree p = {}\n", inputs.max_nets_per_cell);
+}
+
+vector<Block> optimize(const vector<Block>& blocks, const InputData& inputs,
+                       Cost init_cost, const Config& config) {
+  switch (config.engine) {
+    case Engine::Anneal:
+      return perform_sa_partition(blocks, inputs, init_cost, config);
+    case Engine::Tempering:
+      return perform_tempering_partition(blocks, inputs, init_cost, config);
+    case Engine::Multilevel:
+      return perform_multilevel_partition(inputs, config);
+    case Engine::Fm:
+      return perform_fm_refinement(blocks, inputs, init_cost,
+                                   config.budget.time_limit);
+  }
+  throw std::logic_error("unknown engine");
+}
+
+// Cores of a batch, leased to jobs while they run.
+class CoreBudget {
+ public:
+  explicit CoreBudget(size_t ncores) : nfree(ncores) {}
+
+  // Blocks until `ncores` cores are free, and takes them.
+  void acquire(size_t ncores) {
+    std::unique_lock lock{mutex};
+    cv.wait(lock, [&] { return nfree >= ncores; });
+    nfree -= ncores;
+  }
+
+  // Gives back `ncores` cores.
+  void release(size_t ncores) {
+    {
+      std::lock_guard lock{mutex};
+      nfree += ncores;
+    }
+    cv.notify_all();
+  }
+
+ private:
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t nfree;
+};
+
+struct JobResult {
+  size_t ncores = 0;
+  Cost cost = 0;
+  double secs = 0.0;
+  std::optional<string> error;
+};
+
+// Gets the size of the input at `path`, which stands for the work of its job.
+// Inputs that cannot be queried count as empty, and fail when their job runs.
+size_t get_job_size(const string& path) {
+  try {
+    return get_file_size(path);
+  } catch (const std::exception&) {
+    return 0;
+  }
+}
+
+void print_summary(const vector<BatchJob>& jobs,
+                   const vector<JobResult>& results) {
+  fmt::print("{:>4}  {:>5}  {:>9}  {:>10}  {}\n", "Job", "Cores", "Seconds",
+             "Cost", "Input");
+  for (const auto& [i, job] : jobs | enumerate) {
+    const JobResult& result = results[i];
+    if (result.error) {
+      fmt::print("{:>4}  {:>5}  {:>9.1f}  {:>10}  {}\n", i, result.ncores,
+                 result.secs, "failed", job.input_path);
+    } else {
+      fmt::print("{:>4}  {:>5}  {:>9.1f}  {:>10}  {}\n", i, result.ncores,
+                 result.secs, result.cost, job.input_path);
+    }
+  }
+}
+}  // namespace
+
+Cost partition_file(const string& input_path, const string& output_path,
+                    const Config& config) noexcept(false) {
+  const InputData inputs = InputData::read_from(input_path);
+  // Costs of whole partitions are found with `PA2_THREADS` threads
+  WorkerPool cost_pool{config.nthreads};
+
+  vector<Block> optimized_blocks;
+  if (config.resume) {
+    // The chains continue from their checkpoints, so there is no starting
+    // partition to find
+    optimized_blocks = resume_sa_partition(inputs, config);
+  } else {
+    // Find starting partitioning and optimize
+    const auto starting_blocks = find_starting_partition(
+        inputs, config::starting_partition_seed, config.starting_partition);
+    const auto starting_cost = find_cost(starting_blocks, inputs, cost_pool);
+
+    fmt::print("Cost of starting partition = {}\n", starting_cost);
+    if (config.debug_inputs) {
+      debug_print_inputs(inputs, starting_blocks);
+    }
+    optimized_blocks = optimize(starting_blocks, inputs, starting_cost, config);
+  }
+  if (config.fm_polish && config.engine != Engine::Fm) {
+    optimized_blocks =
+        perform_fm_refinement(optimized_blocks, inputs,
+                              find_cost(optimized_blocks, inputs, cost_pool),
+                              config::fm_polish_time_limit);
+  }
+  const auto optimized_cost = find_cost(optimized_blocks, inputs, cost_pool);
+  fmt::print("Final cost = {}\n", optimized_cost);
+
+  // Optionally verify the answer
+  if (config.verity_blocks) {
+    verify_blocks(optimized_blocks, inputs);
+  }
+
+  // Write output
+  std::ofstream outfile(output_path);
+  if (outfile.is_open() == false) {
+    throw std::runtime_error(
+        fmt::format("Failed to open output {}", output_path));
+  }
+
+  fmt::print("Writing output to file {}\n", output_path);
+  write_blocks(outfile, optimized_cost, optimized_blocks, inputs);
+  outfile.flush();
+  outfile.close();
+  if (outfile.fail()) {
+    throw std::runtime_error(
+        fmt::format("Failed to write output {}", output_path));
+  }
+
+  return optimized_cost;
+}
+
+vector<BatchJob> read_manifest(const string& path) noexcept(false) {
+  std::ifstream is(path);
+  if (is.is_open() == false) {
+    throw std::runtime_error(fmt::format("Failed to open manifest {}", path));
+  }
+
+  vector<BatchJob> jobs;
+  string line;
+  for (size_t line_number = 1; std::getline(is, line); line_number += 1) {
+    std::istringstream fields(line);
+    BatchJob job;
+    if ((fields >> job.input_path).fail() || job.input_path[0] == '#') {
+      continue;
+    }
+
+    const auto fail = [&] {
+      throw std::runtime_error(fmt::format(
+          "{}:{}: expected 'INPUT OUTPUT [SECONDS]'", path, line_number));
+    };
+    if ((fields >> job.output_path).fail()) {
+      fail();
+    }
+    if ((fields >> std::ws).eof() == false) {
+      int64_t secs = 0;
+      if ((fields >> secs).fail() || secs <= 0 ||
+          secs > config::max_time_limit.count() ||
+          (fields >> std::ws).eof() == false) {
+        fail();
+      }
+      job.time_limit = std::chrono::seconds(secs);
+    }
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+bool run_batch(const vector<BatchJob>& jobs, const Config& config) {
+  const size_t ncores = std::max<size_t>(config.nthreads, 1);
+
+  // Cores of each job in proportion to the size of its input, with larger
+  // jobs started first so that they do not end up running last.
+  vector<size_t> sizes(jobs.size());
+  std::transform(jobs.begin(), jobs.end(), sizes.begin(),
+                 [](const BatchJob& job) {
+                   return get_job_size(job.input_path);
+                 });
+  const double total_size = std::max<double>(
+      std::accumulate(sizes.begin(), sizes.end(), size_t{0}), 1.0);
+  vector<JobResult> results(jobs.size());
+  for (const auto& [i, size] : sizes | enumerate) {
+    const auto share = std::lround(static_cast<double>(ncores * size) /
+                                   total_size);
+    results[i].ncores = std::clamp<size_t>(share, 1, ncores);
+  }
+  vector<size_t> order(jobs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+  CoreBudget cores{ncores};
+  vector<std::thread> threads;
+  for (const size_t i : order) {
+    cores.acquire(results[i].ncores);
+    fmt::print("Job {} starts on {} cores: {}\n", i, results[i].ncores,
+               jobs[i].input_path);
+
+    threads.emplace_back([&, i] {
+      const BatchJob& job = jobs[i];
+      JobResult& result = results[i];
+      // Each chain runs its own pool of speculative threads, so the lease is
+      // split between chains and speculative threads
+      Config job_config = config;
+      job_config.speculative_threads =
+          std::min(config.speculative_threads, result.ncores);
+      job_config.nthreads = std::max<size_t>(
+          result.ncores / job_config.speculative_threads, 1);
+      if (job.time_limit) {
+        job_config.budget.time_limit = *job.time_limit;
+      }
+
+      const auto begin_time = steady_clock::now();
+      try {
+        result.cost =
+            partition_file(job.input_path, job.output_path, job_config);
+      } catch (const std::exception& e) {
+        fmt::print(stderr, "Job {} failed: {}\n", i, e.what());
+        result.error = e.what();
+      }
+      const std::chrono::duration<double> elapsed =
+          steady_clock::now() - begin_time;
+      result.secs = elapsed.count();
+
+      cores.release(result.ncores);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  print_summary(jobs, results);
+  return std::none_of(results.begin(), results.end(),
+                      [](const JobResult& result) { return result.error; });
+}
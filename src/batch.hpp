@@ -0,0 +1,38 @@
+#ifndef BATCH_HPP_
+#define BATCH_HPP_
+
+#include "config.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+using Cost = std::int64_t;
+
+// Partitions the input at `input_path` with the engine of `config`, writes the
+// partition to `output_path`, and returns its cost.
+Cost partition_file(const std::string& input_path,
+                    const std::string& output_path,
+                    const Config& config) noexcept(false);
+
+// Job of a batch, as a line `INPUT OUTPUT [SECONDS]` of a manifest.
+struct BatchJob {
+  std::string input_path;
+  std::string output_path;
+
+  // Time limit of the job, or none for the one of the batch
+  std::optional<std::chrono::seconds> time_limit;
+};
+
+// Reads the jobs of the manifest at `path`, skipping blank lines and lines
+// starting with `#`.  Throws on malformed lines.
+std::vector<BatchJob> read_manifest(const std::string& path) noexcept(false);
+
+// Runs `jobs` concurrently on `config.nthreads` cores, giving each job cores
+// in proportion to the size of its input, and prints a summary table.
+// Returns whether all of the jobs succeeded.
+bool run_batch(const std::vector<BatchJob>& jobs, const Config& config);
+
+#endif  // BATCH_HPP_
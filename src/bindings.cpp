@@ -0,0 +1,37 @@
+#include "bindings.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// A net gets a dense row if the row is at most this many times larger than the
+// sparse entries it would otherwise take.
+constexpr size_t dense_ratio = 4;
+
+// Rows with at most this many blocks are always dense.
+constexpr size_t always_dense_nblocks = 16;
+}  // namespace
+
+Bindings::Bindings(const InputData& inputs, size_t nblocks)
+    : nblocks(nblocks), rows(inputs.nnets) {
+  size_t dense_size = 0;
+  size_t sparse_size = 0;
+
+  for (NetId net_id = 0; net_id < inputs.nnets; net_id += 1) {
+    const size_t degree = inputs.nets[net_id].size();
+    Row& row = rows[net_id];
+
+    row.is_dense = nblocks <= always_dense_nblocks ||
+                   nblocks <= dense_ratio * degree;
+    if (row.is_dense) {
+      row.offset = dense_size;
+      dense_size += nblocks;
+    } else {
+      row.offset = sparse_size;
+      sparse_size += std::min(degree, nblocks);
+    }
+  }
+
+  dense.resize(dense_size, 0);
+  sparse.resize(sparse_size, Entry{0, 0});
+}
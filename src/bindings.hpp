@@ -0,0 +1,120 @@
+#ifndef BINDINGS_HPP_
+#define BINDINGS_HPP_
+
+#include "data.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Pin counts of nets in blocks, i.e. the number of cells of a net that are
+// currently placed in a block.
+//
+// Counts of each net are stored contiguously.  Nets whose degree is large
+// compared to the number of blocks get a dense row indexed by block id, while
+// the rest get a compact list of (block, count) entries holding only the
+// blocks that the net currently spans.  A net can never span more blocks than
+// its degree, so the list is allocated once and never grows.
+class Bindings {
+ public:
+  Bindings() = default;
+
+  // Allocates the table for `nblocks` blocks, with all counts being zero.
+  Bindings(const InputData& inputs, size_t nblocks);
+
+  // Gets the number of cells of net `net_id` in block `block_id`.
+  uint32_t get(NetId net_id, BlockId block_id) const {
+    const Row& row = rows[net_id];
+    if (row.is_dense) {
+      return dense[row.offset + block_id];
+    }
+    const Entry* entries = &sparse[row.offset];
+    for (uint32_t i = 0; i < row.used; i += 1) {
+      if (entries[i].block_id == block_id) {
+        return entries[i].count;
+      }
+    }
+    return 0;
+  }
+
+  void increment(NetId net_id, BlockId block_id) {
+    Row& row = rows[net_id];
+    if (row.is_dense) {
+      dense[row.offset + block_id] += 1;
+      return;
+    }
+    Entry* entries = &sparse[row.offset];
+    for (uint32_t i = 0; i < row.used; i += 1) {
+      if (entries[i].block_id == block_id) {
+        entries[i].count += 1;
+        return;
+      }
+    }
+    entries[row.used] = Entry{static_cast<uint32_t>(block_id), 1};
+    row.used += 1;
+  }
+
+  // Calls `f(block_id, count)` for every block containing cells of net
+  // `net_id`.
+  template <typename F>
+  void for_each_block(NetId net_id, F&& f) const {
+    const Row& row = rows[net_id];
+    if (row.is_dense) {
+      for (size_t block_id = 0; block_id < nblocks; block_id += 1) {
+        if (dense[row.offset + block_id] != 0) {
+          f(static_cast<BlockId>(block_id), dense[row.offset + block_id]);
+        }
+      }
+      return;
+    }
+    const Entry* entries = &sparse[row.offset];
+    for (uint32_t i = 0; i < row.used; i += 1) {
+      f(static_cast<BlockId>(entries[i].block_id), entries[i].count);
+    }
+  }
+
+  // Decrements a count.  The count must be non-zero.
+  void decrement(NetId net_id, BlockId block_id) {
+    Row& row = rows[net_id];
+    if (row.is_dense) {
+      dense[row.offset + block_id] -= 1;
+      return;
+    }
+    Entry* entries = &sparse[row.offset];
+    for (uint32_t i = 0; i < row.used; i += 1) {
+      if (entries[i].block_id == block_id) {
+        entries[i].count -= 1;
+        if (entries[i].count == 0) {
+          // Keep entries in use packed at the front
+          row.used -= 1;
+          entries[i] = entries[row.used];
+        }
+        return;
+      }
+    }
+  }
+
+ private:
+  struct Row {
+    size_t offset = 0;
+    uint32_t used = 0;
+    bool is_dense = false;
+  };
+
+  struct Entry {
+    uint32_t block_id;
+    uint32_t count;
+  };
+
+  size_t nblocks = 0;
+
+  // NetId -> location of the counts of the net
+  std::vector<Row> rows;
+
+  // Rows of dense nets, `nblocks` counts each
+  std::vector<uint32_t> dense;
+
+  // Entries of sparse nets, `min(degree, nblocks)` entries each
+  std::vector<Entry> sparse;
+};
+
+#endif  // BINDINGS_HPP_
@@ -0,0 +1,15 @@
+#include "boundary_cells.hpp"
+
+#include <vector>
+
+BoundaryCells::BoundaryCells(const InputData& inputs,
+                             const std::vector<Cost>& span_of_net)
+    : ncut_nets(inputs.ncells, 0), position_of_cell(inputs.ncells, 0) {
+  for (NetId net_id = 0; net_id < inputs.nnets; net_id += 1) {
+    if (span_of_net[net_id] > 1) {
+      for (const CellId cell_id : inputs.nets[net_id]) {
+        add_cut_net(cell_id);
+      }
+    }
+  }
+}
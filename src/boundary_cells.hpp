@@ -0,0 +1,67 @@
+#ifndef BOUNDARY_CELLS_HPP_
+#define BOUNDARY_CELLS_HPP_
+
+#include "cost.hpp"
+#include "data.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Cells connected to at least one net spanning more than one block, kept as an
+// indexed set so that a random boundary cell can be drawn in constant time.
+class BoundaryCells {
+ public:
+  BoundaryCells() = default;
+
+  // Collects the boundary cells given the spans of the nets.
+  BoundaryCells(const InputData& inputs, const std::vector<Cost>& span_of_net);
+
+  bool empty() const { return cells.empty(); }
+  size_t size() const { return cells.size(); }
+  CellId operator[](size_t i) const { return cells[i]; }
+
+  // Updates the set after the span of net `net_id` has changed from
+  // `old_span` to `new_span`.  Only changes between one and two blocks matter.
+  void update(NetId net_id, Cost old_span, Cost new_span,
+              const InputData& inputs) {
+    if (old_span == 1 && new_span == 2) {
+      for (const CellId cell_id : inputs.nets[net_id]) {
+        add_cut_net(cell_id);
+      }
+    } else if (old_span == 2 && new_span == 1) {
+      for (const CellId cell_id : inputs.nets[net_id]) {
+        remove_cut_net(cell_id);
+      }
+    }
+  }
+
+ private:
+  void add_cut_net(CellId cell_id) {
+    ncut_nets[cell_id] += 1;
+    if (ncut_nets[cell_id] == 1) {
+      position_of_cell[cell_id] = cells.size();
+      cells.push_back(cell_id);
+    }
+  }
+
+  void remove_cut_net(CellId cell_id) {
+    ncut_nets[cell_id] -= 1;
+    if (ncut_nets[cell_id] == 0) {
+      // Swap with the last cell, then pop
+      const CellId last_cell_id = cells.back();
+      cells[position_of_cell[cell_id]] = last_cell_id;
+      position_of_cell[last_cell_id] = position_of_cell[cell_id];
+      cells.pop_back();
+    }
+  }
+
+  std::vector<CellId> cells;
+
+  // CellId -> number of nets of the cell spanning more than one block
+  std::vector<uint32_t> ncut_nets;
+
+  // CellId -> index of the cell in `cells`, if it is a boundary cell
+  std::vector<size_t> position_of_cell;
+};
+
+#endif  // BOUNDARY_CELLS_HPP_
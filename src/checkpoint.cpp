@@ -0,0 +1,228 @@
+#include "checkpoint.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+#include "mapped_file.hpp"
+#include "sim_anneal.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+constexpr char magic[8] = {'P', 'A', '2', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t version = 1;
+
+// The generator is saved as raw bytes, so checkpoints are only valid for the
+// build that wrote them.
+static_assert(std::is_trivially_copyable_v<Random>);
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t random_size;
+
+  // Identity of the inputs
+  uint64_t ncells;
+  uint64_t nnets;
+  uint64_t npins;
+
+  uint64_t nblocks;
+  int64_t cost;
+  int64_t best_cost;
+  double temp;
+  double temp_factor;
+  int64_t temp_factor_moves;
+  int64_t nmoves;
+  int64_t nstall_passes;
+  int64_t elapsed_ns;
+  uint64_t is_temp_fixed;
+};
+
+// Followed by the generator, then `block_of_cell` and `best_block_of_cell`
+// as 32-bit integers
+size_t file_size(size_t ncells) {
+  return sizeof(Header) + sizeof(Random) + 2 * ncells * sizeof(uint32_t);
+}
+
+void write_block_ids(std::ofstream& os, const vector<BlockId>& block_ids) {
+  const vector<uint32_t> narrowed(block_ids.begin(), block_ids.end());
+  os.write(reinterpret_cast<const char*>(narrowed.data()),
+           static_cast<std::streamsize>(narrowed.size() * sizeof(uint32_t)));
+}
+
+// Reads `ncells` block ids from `bytes`, checking them against `nblocks`.
+vector<BlockId> read_block_ids(const char* bytes, size_t ncells,
+                               size_t nblocks, const string& path) {
+  vector<uint32_t> narrowed(ncells);
+  std::memcpy(narrowed.data(), bytes, ncells * sizeof(uint32_t));
+  for (const uint32_t block_id : narrowed) {
+    if (block_id >= nblocks) {
+      throw std::runtime_error(
+          fmt::format("Checkpoint '{}' has a bad block id", path));
+    }
+  }
+  return vector<BlockId>(narrowed.begin(), narrowed.end());
+}
+}  // namespace
+
+void write_checkpoint(const SimAnneal::Checkpoint& checkpoint,
+                      const InputData& inputs,
+                      const string& path) noexcept(false) {
+  Header header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.random_size = sizeof(Random);
+  header.ncells = inputs.ncells;
+  header.nnets = inputs.nnets;
+  header.npins = inputs.nets.pins.size();
+  header.nblocks = checkpoint.nblocks;
+  header.cost = checkpoint.cost;
+  header.best_cost = checkpoint.best_cost;
+  header.temp = checkpoint.temp;
+  header.temp_factor = checkpoint.temp_factor.temp_factor;
+  header.temp_factor_moves = checkpoint.temp_factor.moves;
+  header.nmoves = checkpoint.nmoves;
+  header.nstall_passes = checkpoint.nstall_passes;
+  header.elapsed_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(checkpoint.elapsed)
+          .count();
+  header.is_temp_fixed = checkpoint.is_temp_fixed;
+
+  const string tmp_path = path + ".tmp";
+  {
+    std::ofstream os(tmp_path, std::ios::binary);
+    os.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(&checkpoint.random),
+             sizeof(Random));
+    write_block_ids(os, checkpoint.block_of_cell);
+    write_block_ids(os, checkpoint.best_block_of_cell);
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error(fmt::format("Failed to rename '{}' to '{}': {}",
+                                         tmp_path, path,
+                                         std::strerror(errno)));
+  }
+}
+
+SimAnneal::Checkpoint read_checkpoint(const InputData& inputs,
+                                      const string& path) noexcept(false) {
+  const MappedFile file(path);
+  const auto fail = [&](const char* message) {
+    throw std::runtime_error(
+        fmt::format("Checkpoint '{}' {}", path, message));
+  };
+
+  Header header{};
+  if (file.size() < sizeof(header) ||
+      std::memcmp(file.data(), magic, sizeof(magic)) != 0) {
+    fail("is not a checkpoint");
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.version != version || header.random_size != sizeof(Random)) {
+    fail("was written by another build");
+  }
+  if (header.ncells != inputs.ncells || header.nnets != inputs.nnets ||
+      header.npins != inputs.nets.pins.size()) {
+    fail("was taken on other inputs");
+  }
+  if (file.size() != file_size(inputs.ncells) || header.nblocks == 0) {
+    fail("is truncated");
+  }
+
+  SimAnneal::Checkpoint checkpoint;
+  checkpoint.nblocks = header.nblocks;
+  checkpoint.cost = header.cost;
+  checkpoint.best_cost = header.best_cost;
+  checkpoint.temp = header.temp;
+  checkpoint.is_temp_fixed = header.is_temp_fixed != 0;
+  checkpoint.temp_factor =
+      TempFactor::State{header.temp_factor, header.temp_factor_moves};
+  checkpoint.nmoves = header.nmoves;
+  checkpoint.nstall_passes = header.nstall_passes;
+  checkpoint.elapsed = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(
+      std::chrono::nanoseconds(header.elapsed_ns));
+
+  const char* cur = file.data() + sizeof(header);
+  std::memcpy(&checkpoint.random, cur, sizeof(Random));
+  cur += sizeof(Random);
+  checkpoint.block_of_cell =
+      read_block_ids(cur, inputs.ncells, header.nblocks, path);
+  cur += inputs.ncells * sizeof(uint32_t);
+  checkpoint.best_block_of_cell =
+      read_block_ids(cur, inputs.ncells, header.nblocks, path);
+
+  // The costs are trusted by the chain from then on, so a checkpoint that was
+  // corrupted, or taken on different inputs of the same sizes, is refused
+  if (find_cost(checkpoint.block_of_cell, checkpoint.nblocks, inputs) !=
+          checkpoint.cost ||
+      find_cost(checkpoint.best_block_of_cell, checkpoint.nblocks, inputs) !=
+          checkpoint.best_cost) {
+    fail("does not match the costs of its partitions");
+  }
+  return checkpoint;
+}
+
+Checkpointer::Checkpointer(const InputData& inputs, string path)
+    : inputs(inputs), path(std::move(path)) {
+  worker = std::thread([this] { work(); });
+}
+
+Checkpointer::~Checkpointer() {
+  {
+    std::lock_guard lock{mutex};
+    is_stopping = true;
+  }
+  cv.notify_all();
+  worker.join();
+}
+
+bool Checkpointer::is_idle() {
+  std::lock_guard lock{mutex};
+  return pending.has_value() == false;
+}
+
+void Checkpointer::submit(SimAnneal::Checkpoint checkpoint) {
+  {
+    std::lock_guard lock{mutex};
+    pending = std::move(checkpoint);
+  }
+  cv.notify_all();
+}
+
+void Checkpointer::work() {
+  std::unique_lock lock{mutex};
+  while (true) {
+    cv.wait(lock, [this] { return is_stopping || pending.has_value(); });
+    if (pending.has_value() == false) {
+      return;
+    }
+
+    // Write without holding the lock, so that the chain can poll `is_idle`
+    lock.unlock();
+    try {
+      write_checkpoint(*pending, inputs, path);
+    } catch (const std::exception& e) {
+      // A failed checkpoint must not stop the run, which may well succeed
+      fmt::print(stderr, "Failed to write checkpoint '{}': {}\n", path,
+                 e.what());
+    }
+    lock.lock();
+
+    pending.reset();
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef CHECKPOINT_HPP_
+#define CHECKPOINT_HPP_
+
+#include "data.hpp"
+#include "sim_anneal.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+// Writes `checkpoint` of a chain on `inputs` to the file at `path`, replacing
+// it atomically by writing to a temporary file first.
+// Throws if the file cannot be written.
+void write_checkpoint(const SimAnneal::Checkpoint& checkpoint,
+                      const InputData& inputs,
+                      const std::string& path) noexcept(false);
+
+// Reads a checkpoint written by `write_checkpoint`.
+// Throws if it cannot be read, was taken on other inputs or by another build,
+// or if its costs do not match those of its partitions.
+SimAnneal::Checkpoint read_checkpoint(const InputData& inputs,
+                                      const std::string& path) noexcept(false);
+
+// Writes checkpoints of a chain to a file on a background thread.
+class Checkpointer {
+ public:
+  // Starts the background thread writing to `path`.
+  Checkpointer(const InputData& inputs, std::string path);
+  ~Checkpointer();
+
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+  // Whether the previous checkpoint has been written.
+  bool is_idle();
+
+  // Hands over a checkpoint to write.  The checkpointer must be idle.
+  void submit(SimAnneal::Checkpoint checkpoint);
+
+ private:
+  void work();
+
+  const InputData& inputs;
+  std::string path;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::optional<SimAnneal::Checkpoint> pending;
+  bool is_stopping = false;
+
+  std::thread worker;
+};
+
+#endif  // CHECKPOINT_HPP_
@@ -1,9 +1,97 @@
 #include "config.hpp"
+#include "telemetry.hpp"
 
 #define FMT_HEADER_ONLY
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace {
+// Parses the value of environment variable `name` as a non-negative integer
+// of at most `max_value`.
+size_t parse_size(const char* name, const char* value,
+                  size_t max_value = std::numeric_limits<size_t>::max()) {
+  char* end = nullptr;
+  errno = 0;
+  const unsigned long long parsed = std::strtoull(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || *value == '-') {
+    throw std::runtime_error(fmt::format(
+        "{} expects a non-negative integer, got '{}'", name, value));
+  }
+  if (errno == ERANGE || parsed > max_value) {
+    throw std::runtime_error(fmt::format(
+        "{} is out of range, expects at most {}, got '{}'", name, max_value,
+        value));
+  }
+  return static_cast<size_t>(parsed);
+}
+
+// Same as above, for values kept as `int64_t`.
+int64_t parse_int64(const char* name, const char* value) {
+  return static_cast<int64_t>(
+      parse_size(name, value, std::numeric_limits<int64_t>::max()));
+}
+
+Engine parse_engine(std::string_view value) {
+  if (value == "anneal") {
+    return Engine::Anneal;
+  }
+  if (value == "tempering") {
+    return Engine::Tempering;
+  }
+  if (value == "multilevel") {
+    return Engine::Multilevel;
+  }
+  if (value == "fm") {
+    return Engine::Fm;
+  }
+  throw std::runtime_error(fmt::format(
+      "PA2_ENGINE expects 'anneal', 'tempering', 'multilevel' or 'fm', got "
+      "'{}'",
+      value));
+}
+
+StartingPartitionMode parse_starting_partition(std::string_view value) {
+  if (value == "balanced") {
+    return StartingPartitionMode::Balanced;
+  }
+  if (value == "bfs") {
+    return StartingPartitionMode::Bfs;
+  }
+  throw std::runtime_error(fmt::format(
+      "PA2_START expects 'balanced' or 'bfs', got '{}'", value));
+}
+
+AcceptanceMode parse_acceptance(std::string_view value) {
+  if (value == "exact") {
+    return AcceptanceMode::Exact;
+  }
+  if (value == "approx") {
+    return AcceptanceMode::Approximate;
+  }
+  throw std::runtime_error(fmt::format(
+      "PA2_ACCEPTANCE expects 'exact' or 'approx', got '{}'", value));
+}
+
+ProposalMode parse_proposal(std::string_view value) {
+  if (value == "uniform") {
+    return ProposalMode::Uniform;
+  }
+  if (value == "connected") {
+    return ProposalMode::Connected;
+  }
+  throw std::runtime_error(fmt::format(
+      "PA2_PROPOSAL expects 'uniform' or 'connected', got '{}'", value));
+}
+}  // namespace
 
 Config::Config() {
   if (std::getenv("PA2_DEBUG_INPUTS")) {
@@ -15,4 +103,132 @@ Config::Config() {
     fmt::print("PA2_VERIFY_BLOCKS is set\n");
     verity_blocks = true;
   }
+
+  if (std::getenv("PA2_PARSE_ONLY")) {
+    fmt::print("PA2_PARSE_ONLY is set\n");
+    parse_only = true;
+  }
+
+  if (const char* value = std::getenv("PA2_WRITE_CACHE")) {
+    if (*value == '\0') {
+      throw std::runtime_error("PA2_WRITE_CACHE expects a path");
+    }
+    write_cache_path = value;
+    fmt::print("PA2_WRITE_CACHE is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_THREADS")) {
+    nthreads = parse_size("PA2_THREADS", value);
+    if (nthreads == 0) {
+      nthreads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    fmt::print("PA2_THREADS is set to {}\n", nthreads);
+  }
+
+  if (const char* value = std::getenv("PA2_SPECULATIVE_THREADS")) {
+    speculative_threads = parse_size("PA2_SPECULATIVE_THREADS", value);
+    if (speculative_threads == 0) {
+      speculative_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    fmt::print("PA2_SPECULATIVE_THREADS is set to {}\n", speculative_threads);
+  }
+
+  if (const char* value = std::getenv("PA2_ENGINE")) {
+    engine = parse_engine(value);
+    fmt::print("PA2_ENGINE is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_START")) {
+    starting_partition = parse_starting_partition(value);
+    fmt::print("PA2_START is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_TIME_LIMIT")) {
+    const size_t secs = parse_size("PA2_TIME_LIMIT", value,
+                                   config::max_time_limit.count());
+    if (secs == 0) {
+      throw std::runtime_error("PA2_TIME_LIMIT expects a positive integer");
+    }
+    budget.time_limit = std::chrono::seconds(secs);
+    fmt::print("PA2_TIME_LIMIT is set to {} s\n", secs);
+  }
+
+  if (const char* value = std::getenv("PA2_MAX_MOVES")) {
+    budget.max_moves = parse_int64("PA2_MAX_MOVES", value);
+    fmt::print("PA2_MAX_MOVES is set to {}\n", budget.max_moves);
+  }
+
+  if (const char* value = std::getenv("PA2_STALL_PASSES")) {
+    budget.max_stall_passes = parse_int64("PA2_STALL_PASSES", value);
+    fmt::print("PA2_STALL_PASSES is set to {}\n", budget.max_stall_passes);
+  }
+
+  if (const char* value = std::getenv("PA2_SEED")) {
+    seed = static_cast<uint64_t>(parse_size("PA2_SEED", value));
+    fmt::print("PA2_SEED is set to {}\n", *seed);
+  }
+
+  if (const char* value = std::getenv("PA2_ACCEPTANCE")) {
+    anneal.acceptance = parse_acceptance(value);
+    fmt::print("PA2_ACCEPTANCE is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_PROPOSAL")) {
+    anneal.proposal = parse_proposal(value);
+    fmt::print("PA2_PROPOSAL is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_SWAP_PERCENT")) {
+    anneal.swap_ratio =
+        static_cast<double>(parse_size("PA2_SWAP_PERCENT", value)) / 100.0;
+    fmt::print("PA2_SWAP_PERCENT is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_CLUSTER_PERCENT")) {
+    anneal.cluster_ratio =
+        static_cast<double>(parse_size("PA2_CLUSTER_PERCENT", value)) / 100.0;
+    fmt::print("PA2_CLUSTER_PERCENT is set to {}\n", value);
+  }
+
+  if (anneal.swap_ratio + anneal.cluster_ratio > 1.0) {
+    throw std::runtime_error(
+        "PA2_SWAP_PERCENT and PA2_CLUSTER_PERCENT add up to more than 100");
+  }
+
+  // Speculative batches only draw single moves, so compound moves would be
+  // dropped without notice
+  if (speculative_threads > 1 &&
+      (anneal.swap_ratio > 0.0 || anneal.cluster_ratio > 0.0)) {
+    throw std::runtime_error(
+        "PA2_SPECULATIVE_THREADS does not take PA2_SWAP_PERCENT or "
+        "PA2_CLUSTER_PERCENT");
+  }
+
+  if (const char* value = std::getenv("PA2_AUDIT")) {
+    anneal.audit_interval = *value == '\0'
+                                ? config::default_audit_interval
+                                : parse_int64("PA2_AUDIT", value);
+    if (anneal.audit_interval == 0) {
+      anneal.audit_interval = config::default_audit_interval;
+    }
+    fmt::print("PA2_AUDIT is set to {} moves\n", anneal.audit_interval);
+  }
+
+  if (const char* value = std::getenv("PA2_TELEMETRY")) {
+    telemetry = std::make_shared<TelemetrySink>(value);
+    fmt::print("PA2_TELEMETRY is set to {}\n", value);
+  }
+
+  if (const char* value = std::getenv("PA2_CHECKPOINT")) {
+    if (*value == '\0') {
+      throw std::runtime_error("PA2_CHECKPOINT expects a path");
+    }
+    checkpoint_path = value;
+    fmt::print("PA2_CHECKPOINT is set to {}\n", value);
+  }
+
+  if (std::getenv("PA2_FM_POLISH")) {
+    fmt::print("PA2_FM_POLISH is set\n");
+    fm_polish = true;
+  }
 }
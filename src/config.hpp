@@ -2,6 +2,11 @@
 #define CONFIG_HPP_
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
 
 namespace {
 constexpr int default_rounds = 10;
@@ -15,11 +20,153 @@ constexpr double default_init_temp_factor = 1.0;
 constexpr double temp_limit = 0.05;
 constexpr double temp_limit_top = 1.0;
 
+constexpr int starting_partition_seed = 42;
+// Nets of larger degree are not followed when ordering cells breadth-first
+// for the starting partition.
+constexpr size_t starting_bfs_max_net_degree = 64;
+
+// Number of passes each tempering replica runs between swap attempts.
+constexpr int64_t tempering_epoch_passes = 500000;
+// Number of tempering replicas when `PA2_THREADS` asks for a single thread.
+constexpr size_t default_tempering_replicas = 4;
+// Ratio of the hottest to the coldest temperature of the tempering ladder.
+constexpr double tempering_ladder_ratio = 2.0;
+
+// Total time of the multilevel V-cycle, unless the time budget is shorter.
+constexpr std::chrono::steady_clock::duration multilevel_time_limit = 10min;
+// Fraction of `multilevel_time_limit` spent on the coarsest level.  The rest is
+// split between the finer levels by their number of cells.
+constexpr double multilevel_coarsest_share = 0.2;
+// Starting temperature of refinement on the finer levels.
+constexpr double multilevel_refine_temp = 0.3;
+// Upper bound of cluster areas, relative to the maximum block area.
+constexpr double multilevel_max_cluster_area_ratio = 0.25;
+// Coarsening stops at this many cells, or this many cells per block.
+constexpr size_t multilevel_min_cells = 200;
+constexpr size_t multilevel_cells_per_block = 10;
+// Coarsening stops when a level keeps more than this fraction of cells.
+constexpr double multilevel_min_shrink = 0.95;
+// Nets of higher degree are ignored when rating pairs of cells.
+constexpr size_t multilevel_max_rated_net_degree = 64;
+
+// An FM pass stops after this many moves without lowering the cost.
+constexpr size_t fm_max_fruitless_moves = 2000;
+// Moves in nets of higher degree do not refresh gains of the other pins.
+constexpr size_t fm_max_updated_net_degree = 256;
+// Time limit of FM polishing after another engine.
+constexpr std::chrono::steady_clock::duration fm_polish_time_limit = 5min;
+
 constexpr std::chrono::steady_clock::duration temp_factor_update_interval = 10s;
+// Minimum number of temperature factor updates within a time limit.
+constexpr int min_temp_factor_updates = 50;
+// Relative temperature drift at which the approximate acceptance table is
+// rebuilt.
+constexpr double acceptance_temp_tolerance = 1e-3;
+
+// Fraction of connected proposals replaced by uniform ones, which keeps every
+// partition reachable.
+constexpr double uniform_proposal_ratio = 0.05;
+// Number of pins drawn when looking for a connected target block.
+constexpr int connected_proposal_tries = 16;
+
+// Largest number of cells moved together in a cluster move.
+constexpr size_t max_cluster_size = 4;
+// Number of pins of a net scanned for cells joining a cluster move.
+constexpr size_t cluster_scan_limit = 32;
+
+// Accepted moves between audits when `PA2_AUDIT` is set without a value.
+constexpr int64_t default_audit_interval = 1000000;
+
+// Number of proposals evaluated concurrently in a speculative batch.
+constexpr size_t speculative_batch_size = 4096;
+// Fraction of conflicting proposals in a speculative batch above which the
+// next batches are evaluated by the committer alone.
+constexpr double speculative_max_conflict_ratio = 0.25;
+// Number of batches evaluated by the committer alone before concurrent
+// evaluation is tried again.
+constexpr size_t speculative_serial_batches = 16;
+
 constexpr std::chrono::steady_clock::duration report_interval = 10s;
+// Interval between checkpoints of a chain when `PA2_CHECKPOINT` is set.
+constexpr std::chrono::steady_clock::duration checkpoint_interval = 60s;
+// Interval between telemetry records of a chain.
+constexpr std::chrono::steady_clock::duration telemetry_interval = 1s;
+// Largest magnitude of cost deltas told apart in telemetry histograms.
+constexpr int64_t telemetry_max_delta = 16;
+// Approximate interval between readings of the time in the SA loop.
+constexpr std::chrono::steady_clock::duration clock_sample_interval = 1ms;
 constexpr std::chrono::steady_clock::duration time_limit = 105min;
+// Largest time limit accepted, far within the range of `steady_clock` time
+// points counted from the start of a run.
+constexpr std::chrono::seconds max_time_limit = 24h * 365;
 }  // namespace config
 
+// Limits of an optimization run.  Zero move and stall limits mean no limit.
+struct Budget {
+  // Wall time of the run.
+  std::chrono::steady_clock::duration time_limit = config::time_limit;
+
+  // Number of accepted moves.
+  int64_t max_moves = 0;
+
+  // Number of passes at `config::temp_limit` without lowering the best cost.
+  int64_t max_stall_passes = 0;
+};
+
+// Optimization engines, selected with `PA2_ENGINE`.
+enum class Engine {
+  // Simulated annealing, with parallel independent chains (`anneal`)
+  Anneal,
+  // Parallel tempering, i.e. replica exchange (`tempering`)
+  Tempering,
+  // Multilevel coarsening and refinement (`multilevel`)
+  Multilevel,
+  // k-way Fiduccia-Mattheyses refinement of the starting partition (`fm`)
+  Fm,
+};
+
+// Starting partitions, selected with `PA2_START`.
+enum class StartingPartitionMode {
+  // Largest cells first, each into the least filled block (`balanced`)
+  Balanced,
+  // Blocks filled in turn with cells in breadth-first order (`bfs`)
+  Bfs,
+};
+
+// Acceptance kernels of SA, selected with `PA2_ACCEPTANCE`.
+enum class AcceptanceMode {
+  // Same decisions as evaluating `std::exp` on every proposal (`exact`)
+  Exact,
+  // Probabilities from a table built for a nearby temperature (`approx`)
+  Approximate,
+};
+
+// Proposal distributions of SA, selected with `PA2_PROPOSAL`.
+enum class ProposalMode {
+  // Uniformly random cell and target block (`uniform`)
+  Uniform,
+  // Boundary cell, moved to a block spanned by one of its nets (`connected`)
+  Connected,
+};
+
+// Choices of SA kernels.
+struct AnnealOptions {
+  AcceptanceMode acceptance = AcceptanceMode::Exact;
+  ProposalMode proposal = ProposalMode::Uniform;
+
+  // Fractions of passes proposing swaps and cluster moves, set with
+  // `PA2_SWAP_PERCENT` and `PA2_CLUSTER_PERCENT`.  The rest propose single
+  // cell moves.
+  double swap_ratio = 0.0;
+  double cluster_ratio = 0.0;
+
+  // Accepted moves between audits of the incremental state, set with
+  // `PA2_AUDIT`, or zero for no audits.
+  int64_t audit_interval = 0;
+};
+
+class TelemetrySink;
+
 struct Config {
   // Constructs a `Config` from environment variables.
   Config();
@@ -29,6 +176,49 @@ struct Config {
 
   // Whether to verify partitions.
   bool verity_blocks = false;
+
+  // Whether to only parse the input and report the parsing throughput.
+  bool parse_only = false;
+
+  // Path to write the input in the binary cache format to, instead of
+  // partitioning it.
+  std::optional<std::string> write_cache_path;
+
+  // Number of SA chains or replicas run in parallel.
+  size_t nthreads = 1;
+
+  // Number of threads evaluating proposals of each SA chain.
+  size_t speculative_threads = 1;
+
+  // Optimization engine.
+  Engine engine = Engine::Anneal;
+
+  // Starting partition of the engine.
+  StartingPartitionMode starting_partition = StartingPartitionMode::Balanced;
+
+  // Limits of the optimization.
+  Budget budget;
+
+  // Seed from which all random seeds are derived, or none for seeds from
+  // `std::random_device`.
+  std::optional<uint64_t> seed;
+
+  // Kernels of SA.
+  AnnealOptions anneal;
+
+  // Whether to polish the result of the engine with FM refinement.
+  bool fm_polish = false;
+
+  // Destination of SA telemetry records, opened from `PA2_TELEMETRY`, or
+  // none.
+  std::shared_ptr<TelemetrySink> telemetry;
+
+  // Path to periodically checkpoint SA chains to, set with `PA2_CHECKPOINT`.
+  // Chains other than the only one append their ids to the path.
+  std::optional<std::string> checkpoint_path;
+
+  // Whether to resume SA chains from their checkpoints, set with `--resume`.
+  bool resume = false;
 };
 
 #endif  // CONFIG_HPP_
@@ -1,31 +1,58 @@
 #include "cost.hpp"
 #include "data.hpp"
+#include "worker_pool.hpp"
 
-#include <parallel_hashmap/phmap.h>
-#include <range/v3/all.hpp>
-
+#include <atomic>
 #include <vector>
 
-using phmap::flat_hash_set;
-using ranges::accumulate;
-using ranges::views::enumerate;
-using ranges::views::transform;
 using std::vector;
 
-Cost find_cost(const vector<Block>& blocks, const InputData& inputs) {
-  auto block_of_cell = blocks_to_block_of_cell(blocks, inputs.ncells);
-  vector<flat_hash_set<size_t>> spans(inputs.nnets);
-
-  for (const auto& [block_id, block] : blocks | enumerate) {
-    for (size_t cell_id : block.cells) {
-      for (size_t net_id : inputs.cells.at(cell_id)) {
-        spans.at(net_id).insert(block_id);
+namespace {
+// Finds the cost of nets [begin, end).  Spans are counted with `stamp`, which
+// maps blocks to the last net seen in them plus one, so that no per-net state
+// needs to be cleared.
+Cost find_cost_of_nets(const vector<BlockId>& block_of_cell,
+                       const InputData& inputs, size_t begin, size_t end,
+                       vector<NetId>& stamp) {
+  Cost cost = 0;
+  for (NetId net_id = begin; net_id < end; net_id += 1) {
+    Cost span = 0;
+    for (const CellId cell_id : inputs.nets[net_id]) {
+      const BlockId block_id = block_of_cell[cell_id];
+      if (stamp[block_id] != net_id + 1) {
+        stamp[block_id] = net_id + 1;
+        span += 1;
       }
     }
+    cost += (span - 1) * (span - 1);
   }
+  return cost;
+}
+}  // namespace
+
+Cost find_cost(const vector<Block>& blocks, const InputData& inputs) {
+  return find_cost(blocks_to_block_of_cell(blocks, inputs.ncells),
+                   blocks.size(), inputs);
+}
+
+Cost find_cost(const vector<Block>& blocks, const InputData& inputs,
+               WorkerPool& pool) {
+  return find_cost(blocks_to_block_of_cell(blocks, inputs.ncells),
+                   blocks.size(), inputs, pool);
+}
+
+Cost find_cost(const vector<BlockId>& block_of_cell, size_t nblocks,
+               const InputData& inputs, WorkerPool& pool) {
+  std::atomic<Cost> cost = 0;
+  pool.parallel_for(inputs.nnets, [&](size_t begin, size_t end) {
+    vector<NetId> stamp(nblocks, 0);
+    cost += find_cost_of_nets(block_of_cell, inputs, begin, end, stamp);
+  });
+  return cost;
+}
 
-  const auto get_size = [](const auto& span) { return span.size(); };
-  const auto net_cost = [](size_t count) { return (count - 1) * (count - 1); };
-  return ranges::accumulate(spans | transform(get_size) | transform(net_cost),
-                            0);
+Cost find_cost(const vector<BlockId>& block_of_cell, size_t nblocks,
+               const InputData& inputs) {
+  vector<NetId> stamp(nblocks, 0);
+  return find_cost_of_nets(block_of_cell, inputs, 0, inputs.nnets, stamp);
 }
@@ -2,11 +2,27 @@
 #define COST_HPP_
 
 #include "data.hpp"
+#include "worker_pool.hpp"
 
 #include <vector>
 
 using Cost = int64_t;
 
+// Finds the connectivity-squared cost of `blocks`, i.e. the sum of
+// `(span - 1)^2` over nets.  A net without pins spans no block and costs 1.
 Cost find_cost(const std::vector<Block>& blocks, const InputData& inputs);
 
+// Same as above, with nets split in ranges among the threads of `pool`.
+Cost find_cost(const std::vector<Block>& blocks, const InputData& inputs,
+               WorkerPool& pool);
+
+// Same as above, for the mapping `block_of_cell` of cells into `nblocks`
+// blocks.
+Cost find_cost(const std::vector<BlockId>& block_of_cell, size_t nblocks,
+               const InputData& inputs, WorkerPool& pool);
+
+// Same as above, on the calling thread only.
+Cost find_cost(const std::vector<BlockId>& block_of_cell, size_t nblocks,
+               const InputData& inputs);
+
 #endif  // COST_HPP_
@@ -1,84 +1,223 @@
 #include "data.hpp"
+#include "input_cache.hpp"
+#include "mapped_file.hpp"
 
 #define FMT_HEADER_ONLY
 #include <fmt/ostream.h>
 #include <parallel_hashmap/phmap.h>
 #include <range/v3/all.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
+using gsl::narrow;
+using gsl::narrow_cast;
 using std::istream;
 using std::string;
 using std::vector;
 
-using ranges::to;
-using ranges::actions::sort;
 using ranges::views::enumerate;
-using ranges::views::transform;
 
 template <typename T>
 using set = phmap::parallel_flat_hash_set<T>;
 
+namespace {
+// Tokenizer of the input format, reading directly from a character buffer.
+class Scanner {
+ public:
+  explicit Scanner(std::string_view text)
+      : begin(text.data()), cur(text.data()), end(text.data() + text.size()) {}
+
+  // Reads an unsigned decimal integer.  Throws if it does not fit in
+  // `size_t`.
+  size_t next_integer() {
+    skip_spaces();
+    if (cur == end || is_digit(*cur) == false) {
+      fail("expects an integer");
+    }
+
+    constexpr size_t max_value = std::numeric_limits<size_t>::max();
+    size_t value = 0;
+    while (cur != end && is_digit(*cur)) {
+      const auto digit = static_cast<size_t>(*cur - '0');
+      if (value > (max_value - digit) / 10) {
+        fail("integer too large");
+      }
+      value = value * 10 + digit;
+      cur += 1;
+    }
+    return value;
+  }
+
+  // Checks that only whitespace remains.
+  void expect_end() {
+    skip_spaces();
+    if (cur != end) {
+      fail("expects the end of input");
+    }
+  }
+
+  // Reads a whitespace-delimited word and checks it against `keyword`.
+  void expect_keyword(std::string_view keyword) {
+    skip_spaces();
+    const char* word_begin = cur;
+    while (cur != end && is_space(*cur) == false) {
+      cur += 1;
+    }
+
+    const std::string_view word(word_begin, cur - word_begin);
+    if (word != keyword) {
+      cur = word_begin;
+      fail(fmt::format("expects keyword '{}'", keyword));
+    }
+  }
+
+  // Throws with `message` and the current position in the input.
+  [[noreturn]] void fail(const string& message) const {
+    const size_t line = std::count(begin, cur, '\n') + 1;
+    throw std::runtime_error(fmt::format("{} at line {} (byte offset {})",
+                                         message, line, cur - begin));
+  }
+
+ private:
+  const char* begin;
+  const char* cur;
+  const char* end;
+
+  static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+  static bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  void skip_spaces() {
+    while (cur != end && is_space(*cur)) {
+      cur += 1;
+    }
+  }
+};
+}  // namespace
+
+void Adjacency::finish_row() {
+  const auto begin = pins.begin() + narrow_cast<ptrdiff_t>(offsets.back());
+  std::sort(begin, pins.end());
+  pins.erase(std::unique(begin, pins.end()), pins.end());
+  offsets.push_back(narrow<uint32_t>(pins.size()));
+}
+
+Adjacency Adjacency::transposed(size_t ncols) const {
+  Adjacency result;
+
+  // Count the length of each row of the result
+  result.offsets.assign(ncols + 1, 0);
+  for (const uint32_t col : pins) {
+    result.offsets[col + 1] += 1;
+  }
+  for (size_t col = 0; col < ncols; col += 1) {
+    result.offsets[col + 1] += result.offsets[col];
+  }
+
+  // Scatter rows in increasing order, so that every row of the result is sorted
+  result.pins.resize(pins.size());
+  vector<uint32_t> cursor(result.offsets.begin(), result.offsets.end() - 1);
+  for (size_t row = 0; row < size(); row += 1) {
+    for (const uint32_t col : (*this)[row]) {
+      result.pins[cursor[col]] = narrow_cast<uint32_t>(row);
+      cursor[col] += 1;
+    }
+  }
+
+  return result;
+}
+
+size_t Adjacency::memory_usage() const {
+  return offsets.capacity() * sizeof(uint32_t) +
+         pins.capacity() * sizeof(uint32_t);
+}
+
 InputData InputData::read_from(std::istream& is) noexcept(false) {
   InputData data;
   data.read(is);
   return data;
 }
 
+InputData InputData::read_from(const std::string& path) noexcept(false) {
+  const MappedFile file(path);
+  if (is_input_cache(file.view())) {
+    return read_input_cache(file.view());
+  }
+  InputData data;
+  data.parse(file.view());
+  return data;
+}
+
 void InputData::read(istream& is) noexcept(false) {
   // enable exceptions on input errors
   is.exceptions(istream::failbit | istream::badbit);
 
-  cell_areas.clear();
-  nets.clear();
+  const string text{std::istreambuf_iterator<char>(is),
+                    std::istreambuf_iterator<char>()};
+  parse(text);
+}
 
-  string ignore_word;
+void InputData::parse(std::string_view text) noexcept(false) {
+  Scanner scanner{text};
 
-  is >> max_block_area >> ignore_word;
-  if (ignore_word != ".cell") {
-    throw std::runtime_error("expects keyword '.cell'");
-  }
-  is >> ncells;
+  cell_areas.clear();
+  nets = Adjacency{};
+
+  max_block_area = scanner.next_integer();
+  scanner.expect_keyword(".cell");
+  ncells = scanner.next_integer();
 
   cell_areas.resize(ncells);
   for (size_t i = 0; i < ncells; i += 1) {
-    size_t index = 0;
-    is >> index;
-    is >> cell_areas[index];
+    const size_t index = scanner.next_integer();
+    if (index >= ncells) {
+      scanner.fail(fmt::format("cell index {} is out of range", index));
+    }
+    cell_areas[index] = scanner.next_integer();
   }
 
-  is >> ignore_word;
-  if (ignore_word != ".net") {
-    throw std::runtime_error("expects keyword '.net'");
-  }
+  scanner.expect_keyword(".net");
 
-  is >> nnets;
-  nets.resize(nnets);
-  cells.resize(ncells);
+  nnets = scanner.next_integer();
+  nets.offsets.reserve(nnets + 1);
 
   // `net` is the index of net
   for (size_t net = 0; net < nnets; net += 1) {
-    size_t ncells_contained = 0;
-    is >> ncells_contained;
+    const size_t ncells_contained = scanner.next_integer();
 
     for (size_t i = 0; i < ncells_contained; i += 1) {
-      size_t cell = 0;
-      is >> cell;
-      nets.at(net).insert(cell);
-      cells.at(cell).insert(net);
+      const size_t cell = scanner.next_integer();
+      if (cell >= ncells) {
+        scanner.fail(fmt::format("net {} contains unknown cell {}", net, cell));
+      }
+      nets.pins.push_back(narrow_cast<uint32_t>(cell));
     }
+    nets.finish_row();
   }
 
+  finalize();
+}
+
+void InputData::finalize() {
+  cells = nets.transposed(ncells);
+
   // Calculate total area
-  total_area = ranges::accumulate(cell_areas, 0);
+  total_area = ranges::accumulate(cell_areas, size_t{0});
 
   // Find max number of nets per cell
-  max_nets_per_cell = ranges::max(
-      cells | transform([](const Cell& cell) { return cell.size(); }));
-
-  return;
+  max_nets_per_cell = 0;
+  for (size_t cell = 0; cell < ncells; cell += 1) {
+    max_nets_per_cell = std::max(max_nets_per_cell, cells[cell].size());
+  }
 }
 
 size_t InputData::min_number_of_blocks() const {
@@ -89,9 +228,10 @@ size_t InputData::min_number_of_blocks() const {
 void InputData::debug_print() const {
   fmt::print("{}\n", *this);
   fmt::print("Cell areas: {}\n", fmt::join(cell_areas, ", "));
-  for (const auto& [i, net] : nets | enumerate) {
-    fmt::print("Net {} contains cells: {}\n", i,
-               fmt::join(net | to<std::vector>() | sort, ", "));
+  fmt::print("Nets and cells take {} bytes\n",
+             nets.memory_usage() + cells.memory_usage());
+  for (size_t i = 0; i < nnets; i += 1) {
+    fmt::print("Net {} contains cells: {}\n", i, fmt::join(nets[i], ", "));
   }
 }
 
@@ -127,12 +267,58 @@ void verify_blocks(const std::vector<Block>& blocks, size_t ncells) {
   }
 }
 
+void verify_blocks(const std::vector<Block>& blocks, const InputData& inputs) {
+  verify_blocks(blocks, inputs.ncells);
+
+  // Verify that the area of each block is that of its cells, and that no block
+  // is larger than allowed
+  for (const auto& [block_id, block] : blocks | enumerate) {
+    size_t area = 0;
+    for (const CellId cell_id : block.cells) {
+      if (cell_id >= inputs.ncells) {
+        throw std::runtime_error(
+            fmt::format("Unknown cell {} found in verification", cell_id));
+      }
+      area += inputs.cell_areas[cell_id];
+    }
+
+    if (area != block.area) {
+      throw std::runtime_error(
+          fmt::format("Block {} has area {} but records area {}", block_id,
+                      area, block.area));
+    }
+    if (area > inputs.max_block_area) {
+      throw std::runtime_error(
+          fmt::format("Block {} has area {} over the maximum {}", block_id,
+                      area, inputs.max_block_area));
+    }
+  }
+}
+
 void write_blocks(std::ostream& os, size_t cost,
                   const std::vector<Block>& blocks, const InputData& inputs) {
   fmt::print(os, "{}\n{}\n", cost, blocks.size());
 
   const auto block_of_cell = blocks_to_block_of_cell(blocks, inputs.ncells);
-  for (const auto& [cell_id, cell] : inputs.cells | enumerate) {
-    fmt::print(os, "{}\n", block_of_cell[cell_id]);
+  for (const BlockId block_id : block_of_cell) {
+    fmt::print(os, "{}\n", block_id);
   }
 }
+
+BlocksFile parse_blocks(std::string_view text, size_t ncells) noexcept(false) {
+  Scanner scanner{text};
+
+  BlocksFile file;
+  file.cost = scanner.next_integer();
+  file.nblocks = scanner.next_integer();
+  file.block_of_cell.resize(ncells);
+  for (BlockId& block_id : file.block_of_cell) {
+    block_id = scanner.next_integer();
+    if (block_id >= file.nblocks) {
+      scanner.fail(fmt::format("block id {} is out of range", block_id));
+    }
+  }
+  scanner.expect_end();
+
+  return file;
+}
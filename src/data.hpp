@@ -4,22 +4,66 @@
 #define FMT_HEADER_ONLY
 #include <fmt/format.h>
 #include <gsl/gsl>
-#include <parallel_hashmap/phmap.h>
 
+#include <cstdint>
 #include <istream>
 #include <ostream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 using NetId = size_t;
 using CellId = size_t;
 using BlockId = size_t;
 
-using Cell = phmap::flat_hash_set<NetId>;
-using Net = phmap::flat_hash_set<CellId>;
+// Immutable adjacency lists in compressed sparse row (CSR) layout.
+// Row `i` consists of `pins[offsets[i]]` up to (excluding)
+// `pins[offsets[i + 1]]`.
+struct Adjacency {
+  using Row = gsl::span<const uint32_t>;
+
+  // Gets row `i`.
+  Row operator[](size_t i) const {
+    return Row(pins.data() + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+
+  // Gets the number of rows.
+  size_t size() const { return offsets.size() - 1; }
+
+  // Ends the row made of the pins pushed since the previous row, sorting and
+  // deduplicating them.
+  void finish_row();
+
+  // Builds the adjacency with rows and columns swapped, that is, row `j` of the
+  // result lists every row of `this` containing `j`.
+  Adjacency transposed(size_t ncols) const;
+
+  // Gets the number of bytes allocated.
+  size_t memory_usage() const;
+
+  std::vector<uint32_t> offsets{0};
+  std::vector<uint32_t> pins;
+};
+
+// Sorted indices of the nets connected to a cell
+using Cell = Adjacency::Row;
+
+// Sorted indices of the cells contained in a net
+using Net = Adjacency::Row;
 
 struct InputData {
   static InputData read_from(std::istream& is) noexcept(false);
+
+  // Reads the file at `path` through a memory mapping.  Files in the binary
+  // cache format of `input_cache.hpp` are loaded without parsing.
+  static InputData read_from(const std::string& path) noexcept(false);
+
   void read(std::istream& is) noexcept(false);
+  void parse(std::string_view text) noexcept(false);
+
+  // Fills in `cells`, `total_area` and `max_nets_per_cell` from `ncells`,
+  // `cell_areas` and `nets`.
+  void finalize();
   size_t min_number_of_blocks() const;
   void debug_print() const;
 
@@ -33,10 +77,10 @@ struct InputData {
   std::vector<size_t> cell_areas;
 
   // Hyperedges, indexed by net numbers
-  std::vector<Net> nets;
+  Adjacency nets;
 
   // Mapping from cell index to net indices
-  std::vector<Cell> cells;
+  Adjacency cells;
 
   size_t total_area = 0;
 };
@@ -93,6 +137,10 @@ inline bool operator!=(const Block& ga, const Block& gb) {
 // Throws if the partitioning is illegal.
 void verify_blocks(const std::vector<Block>& blocks, size_t ncells);
 
+// Same as above, also checking that the area of each block is the total area
+// of its cells, and is within the maximum block area of `inputs`.
+void verify_blocks(const std::vector<Block>& blocks, const InputData& inputs);
+
 // Invert blocks (block-to-cell) as cell-to-block mapping
 std::vector<BlockId> blocks_to_block_of_cell(const std::vector<Block>& blocks,
                                              size_t ncells);
@@ -100,4 +148,16 @@ std::vector<BlockId> blocks_to_block_of_cell(const std::vector<Block>& blocks,
 void write_blocks(std::ostream& os, size_t cost,
                   const std::vector<Block>& blocks, const InputData& inputs);
 
+// Partition as written by `write_blocks`.
+struct BlocksFile {
+  size_t cost = 0;
+  size_t nblocks = 0;
+  std::vector<BlockId> block_of_cell;
+};
+
+// Parses a partition of `ncells` cells written by `write_blocks`.  Throws if
+// the text is malformed, lacks or has extra cells, or has block ids out of
+// range.
+BlocksFile parse_blocks(std::string_view text, size_t ncells) noexcept(false);
+
 #endif  // DATA_HPP_
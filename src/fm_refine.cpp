@@ -0,0 +1,307 @@
+#include "fm_refine.hpp"
+#include "bindings.hpp"
+#include "config.hpp"
+#include "data.hpp"
+#include "indexed_blocks.hpp"
+#include "sim_anneal.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+using std::vector;
+using std::chrono::steady_clock;
+
+namespace {
+// Number of candidates popped between checks of the clock.
+constexpr int64_t clock_check_interval = 1024;
+
+// Move of a cell to a target block, with its gain when last evaluated.
+struct Candidate {
+  Cost gain;
+  CellId cell_id;
+  BlockId to_block_id;
+};
+
+// Orders candidates by gain, breaking ties by ids so that passes are
+// deterministic.
+bool operator<(const Candidate& a, const Candidate& b) {
+  if (a.gain != b.gain) {
+    return a.gain < b.gain;
+  }
+  if (a.cell_id != b.cell_id) {
+    return a.cell_id > b.cell_id;
+  }
+  return a.to_block_id > b.to_block_id;
+}
+
+// Partition state with incrementally maintained cost, refined by FM passes.
+//
+// Gains are updated lazily.  A candidate keeps the gain it had when pushed;
+// upon being popped its gain is re-evaluated, and the candidate is pushed back
+// if the gain has changed.  Stale gains that are too high are thus corrected
+// before a move is made.  Gains that may have risen are pushed afresh for the
+// neighbours of every moved cell.
+class FmRefiner {
+ public:
+  FmRefiner(const vector<Block>& blocks, const InputData& inputs,
+            Cost init_cost)
+      : blocks(blocks, inputs.ncells),
+        bindings(inputs, blocks.size()),
+        span_of_net(inputs.nnets, 0),
+        cost(init_cost),
+        is_locked(inputs.ncells, false),
+        needs_all_targets(inputs.ncells, false),
+        cell_stamp(inputs.ncells, 0),
+        block_stamp(blocks.size(), 0) {
+    for (CellId cell_id = 0; cell_id < inputs.ncells; cell_id += 1) {
+      const BlockId block_id = this->blocks.block_of(cell_id);
+      for (const NetId net_id : inputs.cells[cell_id]) {
+        if (bindings.get(net_id, block_id) == 0) {
+          span_of_net[net_id] += 1;
+        }
+        bindings.increment(net_id, block_id);
+      }
+    }
+  }
+
+  // Performs one pass and rolls back to the lowest cost seen in it.  The pass
+  // stops early at `deadline`.
+  void perform_pass(const InputData& inputs,
+                    steady_clock::time_point deadline) {
+    std::fill(is_locked.begin(), is_locked.end(), false);
+    queue = {};
+    for (CellId cell_id = 0; cell_id < inputs.ncells; cell_id += 1) {
+      push_candidates(cell_id, inputs);
+    }
+
+    moves.clear();
+    Cost best_cost = cost;
+    size_t nbest_moves = 0;
+    int64_t npops = 0;
+
+    while (queue.empty() == false &&
+           moves.size() - nbest_moves < config::fm_max_fruitless_moves) {
+      npops += 1;
+      if (npops % clock_check_interval == 0 &&
+          steady_clock::now() > deadline) {
+        break;
+      }
+
+      Candidate candidate = queue.top();
+      queue.pop();
+      const CellId cell_id = candidate.cell_id;
+      const BlockId to_block_id = candidate.to_block_id;
+      if (is_locked[cell_id] || blocks.block_of(cell_id) == to_block_id) {
+        continue;
+      }
+
+      const Cost gain = gain_of(cell_id, to_block_id, inputs);
+      if (gain != candidate.gain) {
+        candidate.gain = gain;
+        queue.push(candidate);
+        continue;
+      }
+
+      const bool legal =
+          blocks[to_block_id].area + inputs.cell_areas[cell_id] <=
+          inputs.max_block_area;
+      if (legal == false) {
+        continue;
+      }
+
+      const BlockId from_block_id = blocks.block_of(cell_id);
+      move(cell_id, to_block_id, inputs);
+      is_locked[cell_id] = true;
+      moves.push_back(Move{cell_id, from_block_id});
+      if (cost < best_cost) {
+        best_cost = cost;
+        nbest_moves = moves.size();
+      }
+
+      push_neighbour_candidates(cell_id, from_block_id, inputs);
+    }
+
+    // Roll back to the best prefix of moves
+    while (moves.size() > nbest_moves) {
+      const Move last = moves.back();
+      moves.pop_back();
+      move(last.cell_id, last.from_block_id, inputs);
+    }
+  }
+
+  Cost get_cost() const { return cost; }
+  size_t get_nmoves() const { return moves.size(); }
+
+  // Gets the resulting blocks and destroys it.
+  vector<Block> into_blocks() { return blocks.into_blocks(); }
+
+ private:
+  struct Move {
+    CellId cell_id;
+    BlockId from_block_id;
+  };
+
+  // Gets the decrease in cost if cell `cell_id` is moved to `to_block_id`.
+  Cost gain_of(CellId cell_id, BlockId to_block_id,
+               const InputData& inputs) const {
+    const BlockId from_block_id = blocks.block_of(cell_id);
+    Cost cost_delta = 0;
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      Cost new_span = span_of_net[net_id];
+      if (bindings.get(net_id, from_block_id) == 1) {
+        new_span -= 1;
+      }
+      if (bindings.get(net_id, to_block_id) == 0) {
+        new_span += 1;
+      }
+      cost_delta += sqr(new_span - 1) - sqr(span_of_net[net_id] - 1);
+    }
+    return -cost_delta;
+  }
+
+  // Moves cell `cell_id` to `to_block_id`, updating the cost.
+  void move(CellId cell_id, BlockId to_block_id, const InputData& inputs) {
+    cost -= gain_of(cell_id, to_block_id, inputs);
+
+    const BlockId from_block_id = blocks.block_of(cell_id);
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      bindings.decrement(net_id, from_block_id);
+      if (bindings.get(net_id, from_block_id) == 0) {
+        span_of_net[net_id] -= 1;
+      }
+      if (bindings.get(net_id, to_block_id) == 0) {
+        span_of_net[net_id] += 1;
+      }
+      bindings.increment(net_id, to_block_id);
+    }
+    blocks.move(cell_id, to_block_id, inputs.cell_areas[cell_id]);
+  }
+
+  // Pushes moves of cell `cell_id` to every block spanned by its nets.
+  void push_candidates(CellId cell_id, const InputData& inputs) {
+    if (is_locked[cell_id]) {
+      return;
+    }
+
+    const BlockId from_block_id = blocks.block_of(cell_id);
+    stamp += 1;
+    block_stamp[from_block_id] = stamp;
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      if (span_of_net[net_id] < 2) {
+        continue;
+      }
+      bindings.for_each_block(net_id, [&](BlockId block_id, uint32_t) {
+        if (block_stamp[block_id] == stamp) {
+          return;
+        }
+        block_stamp[block_id] = stamp;
+        queue.push(Candidate{gain_of(cell_id, block_id, inputs), cell_id,
+                             block_id});
+      });
+    }
+  }
+
+  // Pushes moves whose gains may have risen after moving cell `cell_id` away
+  // from `from_block_id`.
+  //
+  // A neighbour may now gain more by moving to the block the cell entered.
+  // If a shared net changed its span, or the neighbour lies in the block the
+  // cell left, gains to all its targets may have risen.
+  void push_neighbour_candidates(CellId cell_id, BlockId from_block_id,
+                                 const InputData& inputs) {
+    const BlockId to_block_id = blocks.block_of(cell_id);
+    stamp += 1;
+    neighbours.clear();
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      const Net net = inputs.nets[net_id];
+      if (net.size() > config::fm_max_updated_net_degree) {
+        continue;
+      }
+      const bool is_span_changed =
+          bindings.get(net_id, from_block_id) == 0 ||
+          bindings.get(net_id, to_block_id) == 1;
+      for (const CellId other_id : net) {
+        if (other_id == cell_id || is_locked[other_id]) {
+          continue;
+        }
+        if (cell_stamp[other_id] != stamp) {
+          cell_stamp[other_id] = stamp;
+          needs_all_targets[other_id] =
+              blocks.block_of(other_id) == from_block_id;
+          neighbours.push_back(other_id);
+        }
+        if (is_span_changed) {
+          needs_all_targets[other_id] = true;
+        }
+      }
+    }
+
+    for (const CellId other_id : neighbours) {
+      if (needs_all_targets[other_id]) {
+        push_candidates(other_id, inputs);
+      } else if (blocks.block_of(other_id) != to_block_id) {
+        queue.push(Candidate{gain_of(other_id, to_block_id, inputs), other_id,
+                             to_block_id});
+      }
+    }
+  }
+
+  // Blocks and CellId -> BlockId
+  IndexedBlocks blocks;
+
+  // (NetId, BlockId) -> Int (#cells of net in block)
+  Bindings bindings;
+
+  // NetId -> Int (#blocks spanned by net)
+  vector<Cost> span_of_net;
+
+  Cost cost;
+
+  // Candidates of the current pass, highest gain on top
+  std::priority_queue<Candidate> queue;
+
+  // Moves made in the current pass
+  vector<Move> moves;
+
+  // CellId -> whether the cell has been moved in the current pass
+  vector<bool> is_locked;
+
+  // Neighbours of the last moved cell
+  vector<CellId> neighbours;
+  vector<bool> needs_all_targets;
+
+  // Marks of visited cells and blocks, valid if equal to `stamp`
+  vector<uint32_t> cell_stamp;
+  vector<uint32_t> block_stamp;
+  uint32_t stamp = 0;
+};
+}  // namespace
+
+vector<Block> perform_fm_refinement(const vector<Block>& blocks,
+                                    const InputData& inputs, Cost init_cost,
+                                    steady_clock::duration time_limit) {
+  const steady_clock::time_point begin_time = steady_clock::now();
+  const steady_clock::time_point deadline = begin_time + time_limit;
+  FmRefiner refiner{blocks, inputs, init_cost};
+
+  for (int pass = 1; steady_clock::now() < deadline; pass += 1) {
+    const Cost old_cost = refiner.get_cost();
+    refiner.perform_pass(inputs, deadline);
+    fmt::print("FM pass {} lowers cost from {} to {} with {} moves\n", pass,
+               old_cost, refiner.get_cost(), refiner.get_nmoves());
+    if (refiner.get_cost() >= old_cost) {
+      break;
+    }
+  }
+
+  fmt::print("FM refinement took {:%H:%M:%S}\n",
+             steady_clock::now() - begin_time);
+  return refiner.into_blocks();
+}
@@ -0,0 +1,24 @@
+#ifndef FM_REFINE_HPP_
+#define FM_REFINE_HPP_
+
+#include "config.hpp"
+#include "data.hpp"
+
+#include <chrono>
+#include <vector>
+
+using Cost = std::int64_t;
+
+// Refines `blocks` with k-way Fiduccia-Mattheyses passes under the
+// connectivity-squared cost, until a pass no longer lowers the cost or
+// `time_limit` is reached.
+//
+// Each pass moves every cell at most once, always taking the legal (cell,
+// target block) move of highest gain, then rolls back to the lowest cost seen
+// during the pass.  Only blocks already spanned by a net of the cell are
+// considered as targets, since moving elsewhere can never lower the cost.
+std::vector<Block> perform_fm_refinement(
+    const std::vector<Block>& blocks, const InputData& inputs, Cost init_cost,
+    std::chrono::steady_clock::duration time_limit = config::time_limit);
+
+#endif  // FM_REFINE_HPP_
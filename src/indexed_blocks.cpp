@@ -0,0 +1,21 @@
+#include "indexed_blocks.hpp"
+
+#include <range/v3/all.hpp>
+
+#include <utility>
+#include <vector>
+
+using ranges::views::enumerate;
+using std::vector;
+
+IndexedBlocks::IndexedBlocks(vector<Block> blocks, size_t ncells)
+    : blocks(std::move(blocks)),
+      block_of_cell(ncells),
+      position_of_cell(ncells) {
+  for (const auto& [block_id, block] : this->blocks | enumerate) {
+    for (const auto& [position, cell_id] : block.cells | enumerate) {
+      block_of_cell[cell_id] = block_id;
+      position_of_cell[cell_id] = position;
+    }
+  }
+}
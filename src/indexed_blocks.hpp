@@ -0,0 +1,61 @@
+#ifndef INDEXED_BLOCKS_HPP_
+#define INDEXED_BLOCKS_HPP_
+
+#include "data.hpp"
+
+#include <vector>
+
+// Blocks together with the block and position of every cell, so that a cell
+// can be moved between blocks in constant time.
+//
+// Order of cells inside a block is not preserved across moves.
+class IndexedBlocks {
+ public:
+  IndexedBlocks(std::vector<Block> blocks, size_t ncells);
+
+  const Block& operator[](BlockId block_id) const { return blocks[block_id]; }
+  size_t size() const { return blocks.size(); }
+  auto begin() const { return blocks.begin(); }
+  auto end() const { return blocks.end(); }
+
+  // Gets the block containing cell `cell_id`.
+  BlockId block_of(CellId cell_id) const { return block_of_cell[cell_id]; }
+
+  // Gets the cell-to-block mapping.
+  const std::vector<BlockId>& block_of_cells() const { return block_of_cell; }
+
+  // Moves cell `cell_id` of area `area` to block `to_block_id`.
+  void move(CellId cell_id, BlockId to_block_id, size_t area) {
+    const BlockId from_block_id = block_of_cell[cell_id];
+    Block& from = blocks[from_block_id];
+    Block& to = blocks[to_block_id];
+
+    // Swap with the last cell, then pop
+    const size_t position = position_of_cell[cell_id];
+    const CellId last_cell_id = from.cells.back();
+    from.cells[position] = last_cell_id;
+    position_of_cell[last_cell_id] = position;
+    from.cells.pop_back();
+    from.area -= area;
+
+    position_of_cell[cell_id] = to.cells.size();
+    to.cells.push_back(cell_id);
+    to.area += area;
+
+    block_of_cell[cell_id] = to_block_id;
+  }
+
+  // Gets the blocks and destroys the index.
+  std::vector<Block> into_blocks() { return std::move(blocks); }
+
+ private:
+  std::vector<Block> blocks;
+
+  // CellId -> BlockId
+  std::vector<BlockId> block_of_cell;
+
+  // CellId -> index of the cell in `blocks[block_of_cell[cell_id]].cells`
+  std::vector<size_t> position_of_cell;
+};
+
+#endif  // INDEXED_BLOCKS_HPP_
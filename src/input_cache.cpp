@@ -0,0 +1,256 @@
+#include "input_cache.hpp"
+#include "data.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+constexpr char magic[8] = {'P', 'A', '2', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t version = 1;
+constexpr uint32_t byte_order_mark = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  uint64_t max_block_area;
+  uint64_t total_area;
+  uint64_t max_nets_per_cell;
+  uint64_t ncells;
+  uint64_t nnets;
+  uint64_t npins;
+
+  // Checksum of the file with this field being zero
+  uint64_t checksum;
+};
+
+// Sizes in bytes of the arrays following the header.  The sizes of the header
+// must have been checked with `check_sizes` beforehand.
+struct Layout {
+  explicit Layout(const Header& header)
+      : cell_areas(header.ncells * sizeof(uint64_t)),
+        net_offsets((header.nnets + 1) * sizeof(uint32_t)),
+        cell_offsets((header.ncells + 1) * sizeof(uint32_t)),
+        pins(header.npins * sizeof(uint32_t)) {}
+
+  size_t file_size() const {
+    return sizeof(Header) + cell_areas + 2 * pins + net_offsets +
+           cell_offsets;
+  }
+
+  size_t cell_areas;
+  size_t net_offsets;
+  size_t cell_offsets;
+  size_t pins;
+};
+
+// Word-wise xor-multiply hash over the bytes fed to `update`: each 8-byte word
+// is xored into the hash, which is then multiplied by the FNV prime.  This is
+// not FNV-1a, which folds in a byte at a time, and only guards against
+// truncated or corrupted files.
+class Checksum {
+ public:
+  void update(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    const char* end = bytes + size;
+    if (npending > 0) {
+      const size_t ntaken =
+          std::min<size_t>(sizeof(uint64_t) - npending, end - bytes);
+      std::memcpy(pending + npending, bytes, ntaken);
+      npending += ntaken;
+      bytes += ntaken;
+      if (npending < sizeof(uint64_t)) {
+        return;
+      }
+      fold(pending);
+      npending = 0;
+    }
+    for (; end - bytes >= static_cast<ptrdiff_t>(sizeof(uint64_t));
+         bytes += sizeof(uint64_t)) {
+      fold(bytes);
+    }
+    npending = end - bytes;
+    std::memcpy(pending, bytes, npending);
+  }
+
+  // Gets the checksum, with trailing bytes padded with zeros.
+  uint64_t get() const {
+    Checksum copy = *this;
+    if (copy.npending > 0) {
+      std::memset(copy.pending + copy.npending, 0,
+                  sizeof(uint64_t) - copy.npending);
+      copy.fold(copy.pending);
+    }
+    return copy.hash;
+  }
+
+ private:
+  void fold(const char* bytes) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes, sizeof(uint64_t));
+    hash ^= word;
+    hash *= 0x100000001b3ULL;
+  }
+
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  char pending[sizeof(uint64_t)] = {};
+  size_t npending = 0;
+};
+
+// Reads the arrays of the cache one after another.
+class Reader {
+ public:
+  explicit Reader(string_view bytes) : cur(bytes.data() + sizeof(Header)) {}
+
+  template <typename T>
+  void read(vector<T>& out, size_t size) {
+    out.resize(size / sizeof(T));
+    std::memcpy(out.data(), cur, size);
+    cur += size;
+  }
+
+ private:
+  const char* cur;
+};
+
+[[noreturn]] void fail(const string& message) {
+  throw std::runtime_error(fmt::format("Bad input cache: {}", message));
+}
+
+// Throws unless the sizes of `header` fit the 32-bit ids and offsets of
+// `Adjacency`, and the arrays of those sizes fit in `size` bytes, so that
+// `Layout` can be computed without overflow.
+void check_sizes(const Header& header, size_t size) {
+  const uint64_t max_count = std::numeric_limits<uint32_t>::max();
+  if (header.ncells > std::min<uint64_t>(max_count, size / sizeof(uint64_t)) ||
+      header.nnets > std::min<uint64_t>(max_count, size / sizeof(uint32_t)) ||
+      header.npins > std::min<uint64_t>(max_count, size / sizeof(uint32_t))) {
+    fail(fmt::format("{} cells, {} nets and {} pins do not fit in {} bytes",
+                     header.ncells, header.nnets, header.npins, size));
+  }
+}
+
+// Throws unless the offsets of `adjacency` start at 0, never decrease and end
+// at the number of pins, and every pin is less than `ncols`.
+void check_adjacency(const Adjacency& adjacency, size_t ncols,
+                     const char* name) {
+  const auto& offsets = adjacency.offsets;
+  if (offsets.front() != 0 || offsets.back() != adjacency.pins.size() ||
+      std::is_sorted(offsets.begin(), offsets.end()) == false) {
+    fail(fmt::format("bad offsets of {}", name));
+  }
+  for (const uint32_t pin : adjacency.pins) {
+    if (pin >= ncols) {
+      fail(fmt::format("pin {} of {} out of range", pin, name));
+    }
+  }
+}
+}  // namespace
+
+bool is_input_cache(string_view bytes) {
+  return bytes.size() >= sizeof(magic) &&
+         std::memcmp(bytes.data(), magic, sizeof(magic)) == 0;
+}
+
+void write_input_cache(const InputData& inputs,
+                       const string& path) noexcept(false) {
+  Header header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.byte_order_mark = byte_order_mark;
+  header.max_block_area = inputs.max_block_area;
+  header.total_area = inputs.total_area;
+  header.max_nets_per_cell = inputs.max_nets_per_cell;
+  header.ncells = inputs.ncells;
+  header.nnets = inputs.nnets;
+  header.npins = inputs.nets.pins.size();
+
+  const vector<uint64_t> cell_areas(inputs.cell_areas.begin(),
+                                    inputs.cell_areas.end());
+  const Layout layout{header};
+  const auto for_each_array = [&](auto&& f) {
+    f(cell_areas.data(), layout.cell_areas);
+    f(inputs.nets.offsets.data(), layout.net_offsets);
+    f(inputs.nets.pins.data(), layout.pins);
+    f(inputs.cells.offsets.data(), layout.cell_offsets);
+    f(inputs.cells.pins.data(), layout.pins);
+  };
+
+  Checksum checksum;
+  checksum.update(&header, sizeof(header));
+  for_each_array(
+      [&](const void* data, size_t size) { checksum.update(data, size); });
+  header.checksum = checksum.get();
+
+  std::ofstream os(path, std::ios::binary);
+  os.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for_each_array([&](const void* data, size_t size) {
+    os.write(static_cast<const char*>(data),
+             static_cast<std::streamsize>(size));
+  });
+}
+
+InputData read_input_cache(string_view bytes) noexcept(false) {
+  if (is_input_cache(bytes) == false || bytes.size() < sizeof(Header)) {
+    fail("truncated header");
+  }
+  Header header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.version != version) {
+    fail(fmt::format("version {}, expected {}", header.version, version));
+  }
+  if (header.byte_order_mark != byte_order_mark) {
+    fail("written with another byte order");
+  }
+  check_sizes(header, bytes.size());
+  const Layout layout{header};
+  if (bytes.size() != layout.file_size()) {
+    fail(fmt::format("{} bytes, expected {}", bytes.size(),
+                     layout.file_size()));
+  }
+
+  const uint64_t expected_checksum = header.checksum;
+  header.checksum = 0;
+  Checksum checksum;
+  checksum.update(&header, sizeof(header));
+  checksum.update(bytes.data() + sizeof(Header),
+                  bytes.size() - sizeof(Header));
+  if (checksum.get() != expected_checksum) {
+    fail("checksum mismatch");
+  }
+
+  InputData inputs;
+  inputs.max_block_area = header.max_block_area;
+  inputs.total_area = header.total_area;
+  inputs.max_nets_per_cell = header.max_nets_per_cell;
+  inputs.ncells = header.ncells;
+  inputs.nnets = header.nnets;
+
+  Reader reader{bytes};
+  vector<uint64_t> cell_areas;
+  reader.read(cell_areas, layout.cell_areas);
+  inputs.cell_areas.assign(cell_areas.begin(), cell_areas.end());
+  reader.read(inputs.nets.offsets, layout.net_offsets);
+  reader.read(inputs.nets.pins, layout.pins);
+  reader.read(inputs.cells.offsets, layout.cell_offsets);
+  reader.read(inputs.cells.pins, layout.pins);
+  check_adjacency(inputs.nets, inputs.ncells, "nets");
+  check_adjacency(inputs.cells, inputs.nnets, "cells");
+  return inputs;
+}
@@ -0,0 +1,30 @@
+#ifndef INPUT_CACHE_HPP_
+#define INPUT_CACHE_HPP_
+
+#include "data.hpp"
+
+#include <string>
+#include <string_view>
+
+// Binary cache of `InputData`, written once and loaded in place of parsing.
+//
+// The file is a fixed header followed by the arrays of `InputData` in native
+// byte order: cell areas as 64-bit integers, then the offsets and pins of
+// `nets` and of `cells` as 32-bit integers.  The header holds a magic
+// number, a format version, a byte order mark, the sizes of the arrays and a
+// checksum of the whole file.
+
+// Whether `bytes` starts with the magic number of the cache format.
+bool is_input_cache(std::string_view bytes);
+
+// Writes `inputs` in the cache format to the file at `path`.
+// Throws if the file cannot be written.
+void write_input_cache(const InputData& inputs,
+                       const std::string& path) noexcept(false);
+
+// Loads inputs from the contents of a cache file.
+// Throws if the version, byte order, sizes or checksum do not match, or if the
+// offsets or pins of the adjacencies are out of range.
+InputData read_input_cache(std::string_view bytes) noexcept(false);
+
+#endif  // INPUT_CACHE_HPP_
@@ -1,66 +1,63 @@
+#include "batch.hpp"
 #include "config.hpp"
-#include "cost.hpp"
 #include "data.hpp"
-#include "partition.hpp"
-#include "starting_partition.hpp"
-
-#include <limits>
+#include "input_cache.hpp"
+#include "mapped_file.hpp"
 
 #define FMT_HEADER_ONLY
 #include <fmt/core.h>
-#include <range/v3/all.hpp>
 
-#include <cassert>
-#include <cstdlib>
-#include <fstream>
-#include <optional>
+#include <chrono>
 #include <stdexcept>
+#include <string>
 
-using ranges::views::enumerate;
-using std::ifstream;
-using std::ofstream;
 using std::string;
-using std::vector;
 
-void debug_print_inputs(const InputData& inputs, const vector<Block>& blocks);
+void measure_parse(const string& path);
 
 int main(int argc, char** argv) try {
-  const Config config{};
-
-  if (argc < 3) {
-    throw std::runtime_error("No enough arguments\n");
+  Config config{};
+
+  // `--resume` continues the SA chains checkpointed to `PA2_CHECKPOINT`
+  if (argc >= 2 && string(argv[1]) == "--resume") {  // NOLINT
+    if (config.checkpoint_path.has_value() == false ||
+        config.engine != Engine::Anneal) {
+      throw std::runtime_error(
+          "--resume expects PA2_CHECKPOINT and the anneal engine");
+    }
+    config.resume = true;
+    argc -= 1;
+    argv += 1;  // NOLINT
   }
 
-  ifstream infile(argv[1]);  // NOLINT
-
-  // Read input and find starting partitioning
-  const InputData inputs = InputData::read_from(infile);
-  const auto starting_blocks = find_starting_partition(inputs);
-  const auto starting_cost = find_cost(starting_blocks, inputs);
-
-  fmt::print("Cost of starting partition = {}\n", starting_cost);
-  if (config.debug_inputs) {
-    debug_print_inputs(inputs, starting_blocks);
+  if (config.parse_only && argc >= 2) {
+    measure_parse(argv[1]);  // NOLINT
+    return 0;
   }
 
-  // Optimize
-  const auto optimized_blocks =
-      perform_sa_partition(starting_blocks, inputs, starting_cost);
-  const auto optimized_cost = find_cost(optimized_blocks, inputs);
-  fmt::print("Cost after SA = {}\n", optimized_cost);
+  if (config.write_cache_path && argc >= 2) {
+    const InputData inputs = InputData::read_from(string(argv[1]));  // NOLINT
+    write_input_cache(inputs, *config.write_cache_path);
+    fmt::print("Wrote {} to {}\n", inputs, *config.write_cache_path);
+    return 0;
+  }
 
-  // Optionally verify the answer
-  if (config.verity_blocks) {
-    verify_blocks(optimized_blocks, inputs.ncells);
+  // `--batch MANIFEST` runs the jobs listed in `MANIFEST`
+  if (argc >= 3 && string(argv[1]) == "--batch") {  // NOLINT
+    // Jobs would overwrite each other's checkpoints, and their telemetry
+    // records could not be told apart
+    if (config.checkpoint_path || config.telemetry) {
+      throw std::runtime_error(
+          "--batch does not take PA2_CHECKPOINT or PA2_TELEMETRY");
+    }
+    return run_batch(read_manifest(argv[2]), config) ? 0 : 1;  // NOLINT
   }
 
-  // Write output
-  ofstream outfile(argv[2]);  // NOLINT
+  if (argc < 3) {
+    throw std::runtime_error("No enough arguments\n");
+  }
 
-  fmt::print("Writing output to file {}\n", argv[2]);  // NOLINT
-  write_blocks(outfile, optimized_cost, optimized_blocks, inputs);
-  outfile.flush();
-  outfile.close();
+  partition_file(argv[1], argv[2], config);  // NOLINT
 
   return 0;
 } catch (const std::exception& e) {
@@ -68,16 +65,15 @@ int main(int argc, char** argv) try {
   return 1;
 }
 
-void debug_print_inputs(const InputData& inputs, const vector<Block>& blocks) {
-  inputs.debug_print();
-  for (const auto& [i, block] : blocks | enumerate) {
-    fmt::print("Group {} (area = {}) contains cells: {}\n", i, block.area,
-               fmt::join(block.cells, ", "));
-  }
+void measure_parse(const string& path) {
+  using std::chrono::steady_clock;
+
+  const auto begin_time = steady_clock::now();
+  const InputData inputs = InputData::read_from(path);
+  const std::chrono::duration<double> elapsed =
+      steady_clock::now() - begin_time;
 
-  const auto max_degree =
-      ranges::max(inputs.cells | ranges::views::transform([](const Cell& cell) {
-                    return cell.size();
-                  }));
-  fmt::print("Max degree p = {}\n", max_degree);
+  const double megabytes = static_cast<double>(get_file_size(path)) / 1e6;
+  fmt::print("Parsed {} ({:.3f} MB) in {:.3f} ms, {:.1f} MB/s\n", inputs,
+             megabytes, elapsed.count() * 1e3, megabytes / elapsed.count());
 }
@@ -0,0 +1,81 @@
+#include "mapped_file.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// Throws for the failure of `what` on `path` with the error number `error`.
+[[noreturn]] void throw_errno(const char* what, const std::string& path,
+                              int error = errno) {
+  throw std::runtime_error(
+      fmt::format("failed to {} '{}': {}", what, path, std::strerror(error)));
+}
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path) noexcept(false) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw_errno("open", path);
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw_errno("stat", path, error);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+
+  // Mapping zero bytes is an error, so empty files are left unmapped
+  if (size_ > 0) {
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      throw_errno("map", path, error);
+    }
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(addr);
+  }
+
+  ::close(fd);
+}
+
+size_t get_file_size(const std::string& path) noexcept(false) {
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0) {
+    throw_errno("stat", path);
+  }
+  return static_cast<size_t>(st.st_size);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  // Maps the file at `path`.  Throws if the file cannot be opened or mapped.
+  explicit MappedFile(const std::string& path) noexcept(false);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  std::string_view view() const { return {data_, size_}; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Gets the size in bytes of the file at `path`.  Throws if it cannot be
+// queried.
+size_t get_file_size(const std::string& path) noexcept(false);
+
+#endif  // MAPPED_FILE_HPP_
@@ -0,0 +1,239 @@
+#include "multilevel.hpp"
+#include "config.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+#include "random.hpp"
+#include "sim_anneal.hpp"
+#include "starting_partition.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/chrono.h>
+#include <fmt/core.h>
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using gsl::narrow;
+using gsl::narrow_cast;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::steady_clock;
+
+namespace {
+constexpr CellId unmatched = std::numeric_limits<CellId>::max();
+
+// Refines `blocks` with SA within `budget`, starting at `init_temp`, with
+// the kernels and telemetry of `config`.
+vector<Block> refine(const vector<Block>& blocks, const InputData& inputs,
+                     const Budget& budget, double init_temp, uint64_t seed,
+                     const Config& config) {
+  const Cost init_cost = find_cost(blocks, inputs);
+  SimAnneal sim_anneal{blocks,    inputs,
+                       init_cost, seed,
+                       steady_clock::now(), budget,
+                       init_temp, config.anneal};
+  ProgressReporter reporter{init_cost, 1, config.telemetry};
+
+  while (sim_anneal.should_terminate() == false) {
+    reporter.update(sim_anneal.perform_pass(inputs));
+  }
+  reporter.finish();
+
+  fmt::print("Refined {} cells from cost {} to {}\n", inputs.ncells,
+             init_cost, sim_anneal.get_best_cost());
+  return sim_anneal.into_best_blocks(inputs);
+}
+}  // namespace
+
+CoarseLevel coarsen(const InputData& inputs, size_t max_cluster_area,
+                    int seed) {
+  CoarseLevel level;
+  auto& cluster_of_cell = level.cluster_of_cell;
+  cluster_of_cell.assign(inputs.ncells, unmatched);
+
+  // Visit cells in random order
+  vector<CellId> order(inputs.ncells);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 gen(seed);
+  std::shuffle(order.begin(), order.end(), gen);
+
+  // CellId -> rating of pairing with the visited cell
+  vector<double> rating(inputs.ncells, 0.0);
+  vector<CellId> neighbours;
+  size_t nclusters = 0;
+
+  for (const CellId cell_id : order) {
+    if (cluster_of_cell[cell_id] != unmatched) {
+      continue;
+    }
+
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      const Net net = inputs.nets[net_id];
+      if (net.size() < 2 ||
+          net.size() > config::multilevel_max_rated_net_degree) {
+        continue;
+      }
+      const double weight = 1.0 / static_cast<double>(net.size() - 1);
+      for (const CellId other_id : net) {
+        if (other_id == cell_id || cluster_of_cell[other_id] != unmatched) {
+          continue;
+        }
+        if (rating[other_id] == 0.0) {
+          neighbours.push_back(other_id);
+        }
+        rating[other_id] += weight;
+      }
+    }
+
+    // Pick the heaviest neighbour that fits, and reset ratings
+    CellId mate_id = cell_id;
+    double mate_rating = 0.0;
+    for (const CellId other_id : neighbours) {
+      const bool fits = inputs.cell_areas[cell_id] +
+                            inputs.cell_areas[other_id] <=
+                        max_cluster_area;
+      if (fits && rating[other_id] > mate_rating) {
+        mate_id = other_id;
+        mate_rating = rating[other_id];
+      }
+      rating[other_id] = 0.0;
+    }
+    neighbours.clear();
+
+    cluster_of_cell[cell_id] = nclusters;
+    cluster_of_cell[mate_id] = nclusters;
+    nclusters += 1;
+  }
+
+  // Build the coarse hypergraph
+  InputData& coarse = level.inputs;
+  coarse.max_block_area = inputs.max_block_area;
+  coarse.ncells = nclusters;
+  coarse.cell_areas.assign(nclusters, 0);
+  for (CellId cell_id = 0; cell_id < inputs.ncells; cell_id += 1) {
+    coarse.cell_areas[cluster_of_cell[cell_id]] += inputs.cell_areas[cell_id];
+  }
+
+  vector<uint32_t> clusters;
+  for (NetId net_id = 0; net_id < inputs.nnets; net_id += 1) {
+    clusters.clear();
+    for (const CellId cell_id : inputs.nets[net_id]) {
+      clusters.push_back(narrow_cast<uint32_t>(cluster_of_cell[cell_id]));
+    }
+    std::sort(clusters.begin(), clusters.end());
+    clusters.erase(std::unique(clusters.begin(), clusters.end()),
+                   clusters.end());
+    if (clusters.size() < 2) {
+      continue;
+    }
+
+    coarse.nets.pins.insert(coarse.nets.pins.end(), clusters.begin(),
+                            clusters.end());
+    coarse.nets.offsets.push_back(narrow<uint32_t>(coarse.nets.pins.size()));
+  }
+  coarse.nnets = coarse.nets.size();
+  coarse.finalize();
+
+  return level;
+}
+
+vector<Block> project(const vector<Block>& coarse_blocks,
+                      const CoarseLevel& level, const InputData& inputs) {
+  const auto block_of_cluster =
+      blocks_to_block_of_cell(coarse_blocks, level.inputs.ncells);
+
+  vector<Block> blocks(coarse_blocks.size());
+  for (CellId cell_id = 0; cell_id < inputs.ncells; cell_id += 1) {
+    Block& block = blocks[block_of_cluster[level.cluster_of_cell[cell_id]]];
+    block.cells.push_back(cell_id);
+    block.area += inputs.cell_areas[cell_id];
+  }
+  return blocks;
+}
+
+vector<Block> perform_multilevel_partition(const InputData& inputs,
+                                           const Config& config) {
+  const steady_clock::time_point begin_time = steady_clock::now();
+
+  // Coarsen until the hypergraph is small or stops shrinking
+  const size_t max_cluster_area = static_cast<size_t>(
+      static_cast<double>(inputs.max_block_area) *
+      config::multilevel_max_cluster_area_ratio);
+  const size_t target_ncells =
+      std::max(config::multilevel_min_cells,
+               config::multilevel_cells_per_block *
+                   inputs.min_number_of_blocks());
+
+  vector<CoarseLevel> levels;
+  const InputData* finest = &inputs;
+  while (finest->ncells > target_ncells) {
+    auto level =
+        coarsen(*finest, max_cluster_area,
+                config::starting_partition_seed + narrow<int>(levels.size()));
+    const double shrink = static_cast<double>(level.inputs.ncells) /
+                          static_cast<double>(finest->ncells);
+    if (shrink > config::multilevel_min_shrink) {
+      break;
+    }
+
+    levels.push_back(std::move(level));
+    finest = &levels.back().inputs;
+    fmt::print("Coarsened to level {}: {}\n", levels.size(), *finest);
+  }
+  const InputData& coarsest = *finest;
+
+  // Split the budget between levels
+  const auto inputs_of_level = [&](size_t level) -> const InputData& {
+    return level == 0 ? inputs : levels[level - 1].inputs;
+  };
+  size_t total_fine_cells = 0;
+  for (size_t level = 0; level < levels.size(); level += 1) {
+    total_fine_cells += inputs_of_level(level).ncells;
+  }
+  // The V-cycle takes `multilevel_time_limit`, or the whole budget if shorter
+  const auto time_limit = std::min(config.budget.time_limit,
+                                   config::multilevel_time_limit);
+  const auto budget_of_level = [&](size_t level) {
+    double share = levels.empty() ? 1.0 : config::multilevel_coarsest_share;
+    if (level < levels.size()) {
+      share = (1.0 - config::multilevel_coarsest_share) *
+              static_cast<double>(inputs_of_level(level).ncells) /
+              static_cast<double>(total_fine_cells);
+    }
+
+    Budget budget = config.budget;
+    budget.time_limit =
+        duration_cast<steady_clock::duration>(time_limit * share);
+    if (budget.max_moves > 0) {
+      budget.max_moves = std::max<int64_t>(
+          static_cast<int64_t>(static_cast<double>(budget.max_moves) * share),
+          1);
+    }
+    return budget;
+  };
+
+  // Partition the coarsest level
+  SeedSource next_seed{config.seed};
+  auto blocks = find_starting_partition(
+      coarsest, config::starting_partition_seed, config.starting_partition);
+  blocks = refine(blocks, coarsest, budget_of_level(levels.size()),
+                  config::default_init_temp, next_seed(), config);
+
+  // Project back and refine level by level
+  for (size_t level = levels.size(); level > 0; level -= 1) {
+    const InputData& finer = inputs_of_level(level - 1);
+    blocks = project(blocks, levels[level - 1], finer);
+    blocks = refine(blocks, finer, budget_of_level(level - 1),
+                    config::multilevel_refine_temp, next_seed(), config);
+  }
+
+  fmt::print("Multilevel partitioning took {:%H:%M:%S}\n",
+             steady_clock::now() - begin_time);
+  return blocks;
+}
@@ -0,0 +1,35 @@
+#ifndef MULTILEVEL_HPP_
+#define MULTILEVEL_HPP_
+
+#include "config.hpp"
+#include "data.hpp"
+
+#include <vector>
+
+// Coarse hypergraph obtained by clustering the cells of a finer one.
+struct CoarseLevel {
+  InputData inputs;
+
+  // Fine CellId -> coarse CellId
+  std::vector<CellId> cluster_of_cell;
+};
+
+// Clusters pairs of cells by heavy-edge matching, where the rating of a pair
+// is the sum of 1 / (|net| - 1) over the nets they share, keeping the area of
+// each cluster within `max_cluster_area`.  Nets left with a single pin are
+// dropped, since they never contribute to the cost.
+CoarseLevel coarsen(const InputData& inputs, size_t max_cluster_area,
+                    int seed);
+
+// Projects coarse blocks onto the cells of the finer level.
+std::vector<Block> project(const std::vector<Block>& coarse_blocks,
+                           const CoarseLevel& level, const InputData& inputs);
+
+// Partitions with a multilevel V-cycle: the hypergraph is coarsened until it
+// is small, the coarsest level is partitioned by `find_starting_partition` and
+// SA, and the partition is projected back level by level, refined with
+// low-temperature SA at each level.
+std::vector<Block> perform_multilevel_partition(const InputData& inputs,
+                                                const Config& config);
+
+#endif  // MULTILEVEL_HPP_
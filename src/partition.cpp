@@ -1,358 +1,218 @@
+#include "partition.hpp"
+#include "checkpoint.hpp"
 #include "config.hpp"
 #include "cost.hpp"
 #include "data.hpp"
-#include "partition.hpp"
+#include "random.hpp"
+#include "sim_anneal.hpp"
+#include "starting_partition.hpp"
+#include "worker_pool.hpp"
 
-#include <fmt/chrono.h>
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
 #include <gsl/narrow>
-#include <parallel_hashmap/phmap.h>
-#include <range/v3/action/remove.hpp>
 #include <range/v3/all.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <cmath>
 #include <cstdint>
-#include <cstdio>
-#include <random>
-#include <type_traits>
+#include <exception>
+#include <optional>
+#include <string>
+#include <thread>
 #include <vector>
 
 using gsl::narrow;
-using gsl::narrow_cast;
-using ranges::to;
 using ranges::views::enumerate;
-using ranges::views::transform;
 using std::vector;
 
-using namespace std::chrono_literals;
-using std::chrono::duration_cast;
-using std::chrono::seconds;
 using std::chrono::steady_clock;
 
-template <typename K, typename V>
-using map = phmap::flat_hash_map<K, V>;
-
-template <typename T>
-using set = phmap::flat_hash_set<T>;
-
 namespace {
-struct Key {
-  BlockId block_id;
-  NetId net_id;
-
-  friend size_t hash_value(const Key& key) {
-    return phmap::HashState().combine(0, key.block_id, key.net_id);
-  }
+struct ChainResult {
+  vector<Block> blocks;
+  Cost cost = 0;
 };
 
-bool operator==(Key a, Key b) noexcept {
-  return a.block_id == b.block_id && a.net_id == b.net_id;
+// Gets the checkpoint path of chain `chain_id` out of `nchains`.
+std::string get_checkpoint_path(const std::string& path, size_t nchains,
+                                size_t chain_id) {
+  return nchains == 1 ? path : fmt::format("{}.{}", path, chain_id);
 }
 
-template <typename T>
-constexpr T sqr(T t) noexcept {
-  return t * t;
-}
-
-// Auto-adapting temperature factor that approaches `temp_limit` at time
-// `time_limit`.
-class TempFactor {
- public:
-  TempFactor(double init_temp_factor = config::default_init_temp_factor)
-      : temp_factor(init_temp_factor), last_update_time(steady_clock::now()) {}
-
-  // Gets the factor.
-  double operator()() const { return temp_factor; }
-
-  // Updates the factor. This should be called every time when a pass is
-  // performed.
-  void update(steady_clock::time_point begin_time, double current_temp) {
-    passes += 1;
-    const bool should_update = steady_clock::now() - last_update_time >
-                               config::temp_factor_update_interval;
-    if (should_update == false) {
-      return;
-    }
-
-    const auto remaining_time =
-        config::time_limit - (steady_clock::now() - begin_time);
-    const double remain_secs =
-        static_cast<double>(duration_cast<seconds>(remaining_time).count());
-    const double passes_per_sec = static_cast<double>(passes) / 10.0;
-
-    temp_factor = std::pow(config::temp_limit / current_temp,
-                           1.0 / (remain_secs * passes_per_sec));
-
-    // Correct factor if it goes crazy
-    if (temp_factor <= 0.0) {
-      temp_factor = config::default_init_temp_factor;
-    }
-
-    passes = 0;
-    last_update_time = steady_clock::now();
+// Runs one SA chain until the budget of `config` is used up or `is_stopped` is
+// set, counting time from `begin_time`.  The chain continues from
+// `checkpoint` if any, and otherwise starts from `blocks`.
+ChainResult run_chain(const vector<Block>& blocks, const InputData& inputs,
+                      Cost init_cost,
+                      const std::optional<SimAnneal::Checkpoint>& checkpoint,
+                      uint64_t seed, steady_clock::time_point begin_time,
+                      const Config& config, ProgressReporter& reporter,
+                      size_t nchains, size_t chain_id,
+                      const std::atomic<bool>& is_stopped) {
+  std::optional<std::string> checkpoint_path;
+  std::optional<Checkpointer> checkpointer;
+  if (config.checkpoint_path) {
+    checkpoint_path =
+        get_checkpoint_path(*config.checkpoint_path, nchains, chain_id);
   }
 
- private:
-  double temp_factor;
-
-  steady_clock::time_point last_update_time;
-  int64_t passes = 0;
-};
-
-// Random generator supplying random numbers for `SimAnneal`.
-class Random {
- public:
-  Random(size_t ncells, size_t nblocks)
-      : rd(),
-        gen(rd()),
-        cell_id_gen(0, ncells - 1),
-        block_id_gen(0, nblocks - 1),
-        zero_one_gen(0.0, 1.0) {}
-  CellId cell_id() { return cell_id_gen(gen); }
-  BlockId block_id() { return block_id_gen(gen); }
-  double zero_to_one() { return zero_one_gen(gen); }
-
- private:
-  std::random_device rd;
-  std::mt19937 gen;
-  std::uniform_int_distribution<CellId> cell_id_gen;
-  std::uniform_int_distribution<BlockId> block_id_gen;
-  std::uniform_real_distribution<double> zero_one_gen;
-};
-
-class SimAnneal {
- public:
-  SimAnneal(const std::vector<Block>& blocks, const InputData& inputs,
-            Cost init_cost, double init_temp = config::default_init_temp)
-      : blocks(blocks),
-        cost(init_cost),
-        temp(init_temp),
-        temp_factor(),
-        random(inputs.ncells, blocks.size()),
-        begin_time(steady_clock::now()) {
-    block_of_cell = blocks_to_block_of_cell(blocks, inputs.ncells);
-    populate_span_of_net(inputs);
-    populate_bindings(inputs);
+  const auto start = [&] {
+    if (checkpoint) {
+      return SimAnneal{*checkpoint, inputs, begin_time, config.budget,
+                       config.anneal};
+    }
+    return SimAnneal{blocks,        inputs, init_cost, seed, begin_time,
+                     config.budget, config::default_init_temp,
+                     config.anneal};
+  };
+  SimAnneal sim_anneal = start();
+  if (checkpoint_path) {
+    // Started after reading the checkpoint, which it may overwrite
+    checkpointer.emplace(inputs, *checkpoint_path);
   }
-
-  bool should_terminate() const {
-    const bool is_time_over =
-        (steady_clock::now() - begin_time) > config::time_limit;
-    return is_time_over;
+  if (checkpoint) {
+    fmt::print("Chain {} resumes at cost {}, best seen {}\n", chain_id,
+               sim_anneal.get_cost(), sim_anneal.get_best_cost());
   }
 
-  enum class PassStatus {
-    Success,
-    Abort,
-    UphillReject,
-  };
-
-  struct PassResult {
-    PassStatus status;
-    Cost cost;
-    Cost cost_delta;
-    double temp;
-    double temp_factor;
-  };
-
-  PassResult perform_pass(const InputData& inputs) {
-    const CellId cell_id = random.cell_id();
-    const BlockId from_block_id = block_of_cell[cell_id];
-    const BlockId to_block_id = random.block_id();
-
-    const bool legal = blocks[to_block_id].area + inputs.cell_areas[cell_id] <=
-                       inputs.max_block_area;
-    const bool is_not_move = from_block_id == to_block_id;
-    if (legal == false || is_not_move == true) {
-      return {PassStatus::Abort, 0, 0, temp, temp_factor()};
+  // Checkpoints are skipped while the previous one is still being written
+  steady_clock::time_point next_checkpoint_time =
+      begin_time + config::checkpoint_interval;
+  const auto maybe_checkpoint = [&](steady_clock::time_point now) {
+    if (checkpointer && now >= next_checkpoint_time &&
+        checkpointer->is_idle()) {
+      checkpointer->submit(sim_anneal.take_checkpoint());
+      next_checkpoint_time = now + config::checkpoint_interval;
     }
+  };
 
-    // Calculate change in cost
-    Cost cost_delta = 0;
-    for (const NetId net_id : inputs.cells[cell_id]) {
-      int span_delta = 0;
-      if (bindings[{from_block_id, net_id}] == 1) {
-        // after moving cell away, net will no longer be spanning the block
-        span_delta -= 1;
-      }
-
-      if (bindings[{to_block_id, net_id}] == 0) {
-        // after moving cell in, net will now be (newly) spanning the block
-        span_delta += 1;
-      }
-
-      const Cost old_span = span_of_net[net_id];
-      const Cost new_span = old_span + span_delta;
-
-      cost_delta += sqr(new_span - 1) - sqr(old_span - 1);
-    }
-
-    // determine to accept or reject
-    const bool is_downhill = cost_delta < 0;
-    std::uniform_real_distribution<double> rand_gen(0.0, 1.0);
-    const bool is_rand_accept =
-        random.zero_to_one() <=
-        std::exp(narrow_cast<double>(-cost_delta) / temp);
-
-    if (is_downhill == false && is_rand_accept == false) {
-      return {PassStatus::UphillReject, 0, cost_delta, temp, temp_factor()};
-    }
-
-    // accepted; update records
-    cost += cost_delta;
-
-    for (const NetId net_id : inputs.cells[cell_id]) {
-      int span_delta = 0;
-      if (bindings[{from_block_id, net_id}] == 1) {
-        // after moving cell away, net will no longer be spanning the block
-        span_delta -= 1;
-      }
-      bindings[{from_block_id, net_id}] -= 1;
-
-      if (bindings[{to_block_id, net_id}] == 0) {
-        // after moving cell in, net will now be (newly) spanning the block
-        span_delta += 1;
-      }
-      bindings[{to_block_id, net_id}] += 1;
-
-      if (span_delta != 0) {
-        const Cost old_span = span_of_net[net_id];
-        const Cost new_span = old_span + span_delta;
-        span_of_net[net_id] = new_span;
-      }
+  if (config.speculative_threads > 1) {
+    WorkerPool pool{config.speculative_threads};
+    steady_clock::time_point last_time = begin_time;
+    const auto on_result = [&](const SimAnneal::PassResult& res) {
+      reporter.update(res, chain_id);
+      last_time = res.time;
+    };
+    while (sim_anneal.should_terminate() == false && is_stopped == false) {
+      sim_anneal.perform_speculative_passes(inputs, pool, on_result);
+      // Between batches, where the state is settled
+      maybe_checkpoint(last_time);
     }
-
-    // Move the cell
-    block_of_cell[cell_id] = to_block_id;
-    blocks[from_block_id].cells |= ranges::actions::remove(cell_id);
-    blocks[from_block_id].area -= inputs.cell_areas[cell_id];
-    blocks[to_block_id].cells.emplace_back(cell_id);
-    blocks[to_block_id].area += inputs.cell_areas[cell_id];
-
-    // Update and clamp temperature
-    temp *= temp_factor();
-    temp = std::clamp(temp, config::temp_limit, config::temp_limit_top);
-
-    temp_factor.update(begin_time, temp);
-
-    return PassResult{PassStatus::Success, cost, cost_delta, temp,
-                      temp_factor()};
   }
 
-  // Gets the resulting blocks and destroys it.
-  // It is not allowed to do anything with this instance of `SimAnneal` after
-  // calling this method.
-  vector<Block> into_blocks() { return std::move(blocks); }
-
- private:
-  vector<Block> blocks;
-
-  // (BlockId, NetId) -> Int
-  map<Key, size_t> bindings;
-
-  // CellId -> BlockId
-  vector<BlockId> block_of_cell;
-
-  // NetId -> Int (#blocks spanned by net)
-  vector<Cost> span_of_net;
+  while (sim_anneal.should_terminate() == false && is_stopped == false) {
+    const auto res = sim_anneal.perform_pass(inputs);
+    reporter.update(res, chain_id);
+    maybe_checkpoint(res.time);
+  }
 
-  Cost cost;
-  double temp;
-  TempFactor temp_factor;
-  Random random;
+  reporter.finish(chain_id);
 
-  steady_clock::time_point begin_time;
+  const Cost cost = sim_anneal.get_best_cost();
+  fmt::print("Chain {} ends at cost {}, best seen {} (gap {})\n", chain_id,
+             sim_anneal.get_cost(), cost, sim_anneal.get_cost() - cost);
+  print_move_stats(sim_anneal, chain_id);
+  return ChainResult{sim_anneal.into_best_blocks(inputs), cost};
+}
 
-  void populate_span_of_net(const InputData& inputs) {
-    vector<set<BlockId>> blocks_of_net(inputs.nnets);
-    for (const auto& [block_id, block] : blocks | enumerate) {
-      for (const CellId cell_id : block.cells) {
-        for (const NetId net_id : inputs.cells.at(cell_id)) {
-          blocks_of_net.at(net_id).insert(block_id);
-        }
-      }
-    }
+// Runs a chain for each entry of `checkpoints` and returns the best partition
+// among them.  Chains with a checkpoint continue from it.  Of the others,
+// chain 0 starts from `blocks`, and the rest from differently seeded starting
+// partitions of their own.
+vector<Block> run_chains(
+    const vector<Block>& blocks, const InputData& inputs, Cost init_cost,
+    const Config& config,
+    const vector<std::optional<SimAnneal::Checkpoint>>& checkpoints) {
+  const steady_clock::time_point begin_time = steady_clock::now();
+  const size_t nchains = checkpoints.size();
+  ProgressReporter reporter{init_cost, nchains, config.telemetry};
+
+  SeedSource next_seed{config.seed};
+  vector<uint64_t> seeds(nchains);
+  for (auto& seed : seeds) {
+    seed = next_seed();
+  }
 
-    // Transform blocks_of_net to span sizes
-    span_of_net = blocks_of_net | transform([](const set<BlockId>& bs) {
-                    return narrow<Cost>(bs.size());
-                  }) |
-                  to<vector<Cost>>();
+  std::atomic<bool> is_stopped = false;
+  if (nchains == 1) {
+    return run_chain(blocks, inputs, init_cost, checkpoints[0], seeds[0],
+                     begin_time, config, reporter, nchains, 0, is_stopped)
+        .blocks;
   }
 
-  void populate_bindings(const InputData& inputs) {
-    for (const auto& [block_id, block] : blocks | enumerate) {
-      for (const CellId cell_id : block.cells) {
-        const auto& cell = inputs.cells[cell_id];
-        for (const NetId net_id : cell) {
-          bindings[{block_id, net_id}] += 1;
-        }
+  // Chain 0 runs on this thread, and the others on their own threads.  The
+  // first failing chain stops the others, so that the error is not held back
+  // until the end of the time limit.
+  vector<ChainResult> results(nchains);
+  vector<std::exception_ptr> errors(nchains);
+  const auto run = [&](size_t chain_id) {
+    try {
+      if (chain_id == 0 || checkpoints[chain_id]) {
+        results[chain_id] =
+            run_chain(blocks, inputs, init_cost, checkpoints[chain_id],
+                      seeds[chain_id], begin_time, config, reporter, nchains,
+                      chain_id, is_stopped);
+        return;
       }
+      const auto starting_blocks = find_starting_partition(
+          inputs, config::starting_partition_seed + narrow<int>(chain_id),
+          config.starting_partition);
+      const Cost starting_cost = find_cost(starting_blocks, inputs);
+      results[chain_id] =
+          run_chain(starting_blocks, inputs, starting_cost, std::nullopt,
+                    seeds[chain_id], begin_time, config, reporter, nchains,
+                    chain_id, is_stopped);
+    } catch (...) {
+      errors[chain_id] = std::current_exception();
+      is_stopped = true;
     }
+  };
+  vector<std::thread> threads;
+  for (size_t chain_id = 1; chain_id < nchains; chain_id += 1) {
+    threads.emplace_back(run, chain_id);
   }
-};
-
-class ProgressReporter {
- public:
-  ProgressReporter(Cost init_cost)
-      : last_update_time(steady_clock::now()),
-        begin_time(steady_clock::now()),
-        init_cost(init_cost) {}
-
-  // Updates value stored in the reporter.
-  // If elapsed time since last print is long enough, print out info.
-  void update(const SimAnneal::PassResult& res) {
-    if (res.status == SimAnneal::PassStatus::Success) {
-      num_success += 1;
-    }
+  run(0);
 
-    const bool is_time_to_print =
-        steady_clock::now() - last_update_time > config::report_interval;
-    if (is_time_to_print == false) {
-      return;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
     }
-
-    const double pass_per_sec =
-        static_cast<double>(num_success) /
-        static_cast<double>(
-            duration_cast<seconds>(config::report_interval).count());
-    const double opt_rate =
-        static_cast<double>(res.cost) / static_cast<double>(init_cost) * 100.0;
-    fmt::print(
-        "Cost {:>10}  |  Opt {:<7.3}%  |  Elapsed {:%H:%M:%S}  |  Temp "
-        "{:<12.9}  |  TempFactor "
-        "{:<12.9}  |  PassPerSec {:<12.9}\n",
-        res.cost, opt_rate, steady_clock::now() - begin_time, res.temp,
-        res.temp_factor, pass_per_sec);
-    fflush(stdout);
-
-    last_update_time = steady_clock::now();
-    num_success = 0;
   }
 
- private:
-  steady_clock::time_point last_update_time;
-  steady_clock::time_point begin_time;
-  int64_t num_success = 0;
-  Cost init_cost;
-};
+  const auto by_cost = [](const ChainResult& a, const ChainResult& b) {
+    return a.cost < b.cost;
+  };
+  auto best = std::min_element(results.begin(), results.end(), by_cost);
+  fmt::print("Best chain is {}\n", best - results.begin());
 
+  return std::move(best->blocks);
+}
 }  // namespace
 
 std::vector<Block> perform_sa_partition(const std::vector<Block>& blocks,
-                                        const InputData& inputs,
-                                        Cost init_cost) {
-  SimAnneal sim_anneal{blocks, inputs, init_cost};
-  ProgressReporter reporter{init_cost};
+                                        const InputData& inputs, Cost init_cost,
+                                        const Config& config) {
+  const size_t nchains = std::max<size_t>(config.nthreads, 1);
+  return run_chains(blocks, inputs, init_cost, config,
+                    vector<std::optional<SimAnneal::Checkpoint>>(nchains));
+}
 
-  while (sim_anneal.should_terminate() == false) {
-    const auto res = sim_anneal.perform_pass(inputs);
-    if (res.status == SimAnneal::PassStatus::Success) {
-      reporter.update(res);
-    }
+std::vector<Block> resume_sa_partition(const InputData& inputs,
+                                       const Config& config) noexcept(false) {
+  const size_t nchains = std::max<size_t>(config.nthreads, 1);
+  vector<std::optional<SimAnneal::Checkpoint>> checkpoints(nchains);
+  for (size_t chain_id = 0; chain_id < nchains; chain_id += 1) {
+    checkpoints[chain_id] = read_checkpoint(
+        inputs,
+        get_checkpoint_path(*config.checkpoint_path, nchains, chain_id));
   }
 
-  const auto optimized_blocks = sim_anneal.into_blocks();
-  return optimized_blocks;
+  // Progress is reported against the cost chain 0 resumes at
+  const Cost init_cost = checkpoints[0]->cost;
+  return run_chains({}, inputs, init_cost, config, checkpoints);
 }
@@ -1,14 +1,24 @@
 #ifndef SA_HPP_
 #define SA_HPP_
 
+#include "config.hpp"
 #include "data.hpp"
 
 #include <vector>
 
 using Cost = std::int64_t;
 
+// Optimizes `blocks` with SA until the time limit.
+// With `config.nthreads` > 1, that many independent chains run in parallel,
+// and the partition of the lowest cost among them is returned.
 std::vector<Block> perform_sa_partition(const std::vector<Block>& blocks,
-                                        const InputData& inputs,
-                                        Cost init_cost);
+                                        const InputData& inputs, Cost init_cost,
+                                        const Config& config);
+
+// Continues the chains checkpointed to `config.checkpoint_path` by a run with
+// as many chains, without a starting partition.
+// Throws if a checkpoint cannot be read or does not match `inputs`.
+std::vector<Block> resume_sa_partition(const InputData& inputs,
+                                       const Config& config) noexcept(false);
 
 #endif  // SA_HPP_
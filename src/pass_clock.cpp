@@ -0,0 +1,25 @@
+#include "pass_clock.hpp"
+#include "config.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+using std::chrono::steady_clock;
+
+void PassClock::sample() {
+  const steady_clock::time_point sampled = steady_clock::now();
+  const double elapsed =
+      std::chrono::duration<double>(sampled - time).count();
+  const double target =
+      std::chrono::duration<double>(config::clock_sample_interval).count();
+  time = sampled;
+
+  // Scale towards the target interval, by at most a factor of 2 at a time so
+  // that a single slow pass does not throw the calibration off
+  const double scale =
+      elapsed > 0.0 ? std::clamp(target / elapsed, 0.5, 2.0) : 2.0;
+  passes_per_sample = std::max<int64_t>(
+      static_cast<int64_t>(static_cast<double>(passes_per_sample) * scale), 1);
+  countdown = passes_per_sample;
+}
@@ -0,0 +1,36 @@
+#ifndef PASS_CLOCK_HPP_
+#define PASS_CLOCK_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+// Clock for hot loops, which reads the time only once every few passes.
+//
+// The number of passes between readings adapts to the measured pass rate, so
+// that readings are about `config::clock_sample_interval` apart.  Consumers
+// get the time of the last reading, which lags by at most about that much.
+class PassClock {
+ public:
+  PassClock() : time(std::chrono::steady_clock::now()) {}
+
+  // Counts a pass, reading the time if due.
+  void tick() {
+    countdown -= 1;
+    if (countdown == 0) {
+      sample();
+    }
+  }
+
+  // Gets the time of the last reading.
+  std::chrono::steady_clock::time_point now() const { return time; }
+
+ private:
+  // Reads the time and recalibrates the number of passes between readings.
+  void sample();
+
+  std::chrono::steady_clock::time_point time;
+  int64_t passes_per_sample = 1;
+  int64_t countdown = 1;
+};
+
+#endif  // PASS_CLOCK_HPP_
@@ -0,0 +1,128 @@
+#ifndef RANDOM_HPP_
+#define RANDOM_HPP_
+
+#include "data.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+
+// Advances `state` and returns the next output of splitmix64.
+inline uint64_t splitmix64(uint64_t& state) {
+  state += 0x9e3779b97f4a7c15;
+  uint64_t z = state;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+// The xoshiro256++ generator of Blackman and Vigna, with its state seeded by
+// splitmix64.  Satisfies UniformRandomBitGenerator.
+class Xoshiro256pp {
+ public:
+  using result_type = uint64_t;
+
+  explicit Xoshiro256pp(uint64_t seed) {
+    for (auto& word : state) {
+      word = splitmix64(seed);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    const uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+    const uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+  }
+
+ private:
+  static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  std::array<uint64_t, 4> state;
+};
+
+// Random numbers supplying `SimAnneal`, drawn from `Generator` in batches.
+//
+// `Generator` is any 64-bit UniformRandomBitGenerator constructible from a
+// 64-bit seed, e.g. `Xoshiro256pp` or `std::mt19937_64`.
+template <typename Generator>
+class BasicRandom {
+ public:
+  BasicRandom(size_t ncells, size_t nblocks, uint64_t seed)
+      : gen(seed), ncells(ncells), nblocks(nblocks) {}
+
+  CellId cell_id() { return index(ncells); }
+  BlockId block_id() { return index(nblocks); }
+
+  // Gets a uniform index in [0, bound), by multiply-shift on the upper 32 bits
+  // of a draw, which avoids a division.  The bias is at most bound / 2^32.
+  size_t index(size_t bound) { return ((next() >> 32) * bound) >> 32; }
+
+  // Gets a uniform double in [0, 1).
+  double zero_to_one() {
+    return static_cast<double>(next() >> 11) * 0x1.0p-53;
+  }
+
+ private:
+  static constexpr size_t batch_size = 256;
+
+  uint64_t next() {
+    if (position == batch_size) {
+      refill();
+    }
+    const uint64_t value = batch[position];
+    position += 1;
+    return value;
+  }
+
+  void refill() {
+    for (auto& value : batch) {
+      value = gen();
+    }
+    position = 0;
+  }
+
+  Generator gen;
+  size_t ncells;
+  size_t nblocks;
+
+  std::array<uint64_t, batch_size> batch{};
+  size_t position = batch_size;
+};
+
+using Random = BasicRandom<Xoshiro256pp>;
+
+// Source of seeds for chains and replicas.  Seeds come from
+// `std::random_device`, or are derived from a fixed seed if one is given, so
+// that runs can be reproduced.
+class SeedSource {
+ public:
+  explicit SeedSource(std::optional<uint64_t> seed) : seed(seed) {}
+
+  uint64_t operator()() {
+    if (seed.has_value()) {
+      return splitmix64(*seed);
+    }
+    return (static_cast<uint64_t>(device()) << 32) | device();
+  }
+
+ private:
+  std::optional<uint64_t> seed;
+  std::random_device device;
+};
+
+#endif  // RANDOM_HPP_
@@ -0,0 +1,380 @@
+#include "sim_anneal.hpp"
+
+#include <fmt/chrono.h>
+#include <gsl/narrow>
+#include <parallel_hashmap/phmap.h>
+#include <range/v3/all.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+using gsl::narrow;
+using ranges::to;
+using ranges::views::enumerate;
+using ranges::views::transform;
+using std::vector;
+
+using std::chrono::steady_clock;
+
+template <typename T>
+using set = phmap::flat_hash_set<T>;
+
+namespace {
+// Lower bound of the length of the move log before taking a snapshot.
+constexpr size_t min_logged_moves = 1 << 16;
+
+// Inverts a cell-to-block mapping into `nblocks` blocks.
+vector<Block> block_of_cell_to_blocks(const vector<BlockId>& block_of_cell,
+                                      size_t nblocks,
+                                      const InputData& inputs) {
+  vector<Block> blocks(nblocks);
+  for (CellId cell_id = 0; cell_id < block_of_cell.size(); cell_id += 1) {
+    blocks[block_of_cell[cell_id]].cells.push_back(cell_id);
+    blocks[block_of_cell[cell_id]].area += inputs.cell_areas[cell_id];
+  }
+  return blocks;
+}
+}  // namespace
+
+SimAnneal::SimAnneal(const std::vector<Block>& blocks, const InputData& inputs,
+                     Cost init_cost, uint64_t seed,
+                     steady_clock::time_point begin_time,
+                     const Budget& budget, double init_temp,
+                     const AnnealOptions& options)
+    : blocks(blocks, inputs.ncells),
+      bindings(inputs, blocks.size()),
+      cost(init_cost),
+      temp(init_temp),
+      temp_factor(budget, init_temp),
+      random(inputs.ncells, blocks.size(), seed),
+      acceptance(options.acceptance),
+      proposal_mode(options.proposal),
+      is_mixing_moves(options.swap_ratio > 0.0 || options.cluster_ratio > 0.0),
+      swap_ratio(options.swap_ratio),
+      cluster_ratio(options.cluster_ratio),
+      begin_time(begin_time),
+      budget(budget),
+      audit_interval(options.audit_interval),
+      best_cost(init_cost),
+      max_logged_moves(std::max(inputs.ncells, min_logged_moves)) {
+  populate_span_of_net(inputs);
+  populate_bindings(inputs);
+  if (proposal_mode == ProposalMode::Connected) {
+    boundary_cells = BoundaryCells(inputs, span_of_net);
+  }
+  if (audit_interval > 0) {
+    auditor = std::make_unique<Auditor>(inputs, this->blocks.block_of_cells(),
+                                        init_cost);
+  }
+}
+
+SimAnneal::SimAnneal(const Checkpoint& checkpoint, const InputData& inputs,
+                     steady_clock::time_point begin_time,
+                     const Budget& budget, const AnnealOptions& options)
+    : SimAnneal(block_of_cell_to_blocks(checkpoint.block_of_cell,
+                                        checkpoint.nblocks, inputs),
+                inputs, checkpoint.cost, 0, begin_time - checkpoint.elapsed,
+                budget, checkpoint.temp, options) {
+  is_temp_fixed = checkpoint.is_temp_fixed;
+  temp_factor.restore(checkpoint.temp_factor);
+  random = checkpoint.random;
+  nmoves = checkpoint.nmoves;
+  audited_nmoves = nmoves;
+  nstall_passes = checkpoint.nstall_passes;
+  best_cost = checkpoint.best_cost;
+  if (best_cost < cost) {
+    best_block_of_cell = checkpoint.best_block_of_cell;
+  }
+}
+
+SimAnneal::Checkpoint SimAnneal::take_checkpoint() const {
+  Checkpoint checkpoint;
+  checkpoint.nblocks = blocks.size();
+  checkpoint.block_of_cell = blocks.block_of_cells();
+  checkpoint.best_block_of_cell = best_block_of_cell;
+  if (best_block_of_cell.empty()) {
+    // Undo moves back to the best state
+    checkpoint.best_block_of_cell = checkpoint.block_of_cell;
+    for (auto it = moves_since_best.rbegin(); it != moves_since_best.rend();
+         ++it) {
+      checkpoint.best_block_of_cell[it->cell_id] = it->from_block_id;
+    }
+  }
+  checkpoint.cost = cost;
+  checkpoint.best_cost = best_cost;
+  checkpoint.temp = temp;
+  checkpoint.is_temp_fixed = is_temp_fixed;
+  checkpoint.temp_factor = temp_factor.get_state();
+  checkpoint.random = random;
+  checkpoint.nmoves = nmoves;
+  checkpoint.nstall_passes = nstall_passes;
+  checkpoint.elapsed = clock.now() - begin_time;
+  return checkpoint;
+}
+
+vector<Block> SimAnneal::into_best_blocks(const InputData& inputs) {
+  if (auditor != nullptr) {
+    auditor->finish();
+  }
+
+  if (best_block_of_cell.empty()) {
+    // Undo moves back to the best state
+    for (auto it = moves_since_best.rbegin(); it != moves_since_best.rend();
+         ++it) {
+      blocks.move(it->cell_id, it->from_block_id,
+                  inputs.cell_areas[it->cell_id]);
+    }
+    return blocks.into_blocks();
+  }
+
+  vector<Block> best_blocks(blocks.size());
+  for (const auto& [cell_id, block_id] : best_block_of_cell | enumerate) {
+    best_blocks[block_id].cells.push_back(cell_id);
+    best_blocks[block_id].area += inputs.cell_areas[cell_id];
+  }
+  return best_blocks;
+}
+
+SimAnneal::PassResult SimAnneal::perform_swap(const InputData& inputs) {
+  const auto [cell_id, to_block_id] = propose(inputs);
+  const BlockId from_block_id = blocks.block_of(cell_id);
+  const Block& from = blocks[from_block_id];
+  const Block& to = blocks[to_block_id];
+  if (from_block_id == to_block_id || to.cells.empty()) {
+    return abort_pass();
+  }
+
+  const CellId other_id = to.cells[random.index(to.cells.size())];
+  const size_t area = inputs.cell_areas[cell_id];
+  const size_t other_area = inputs.cell_areas[other_id];
+  const bool legal =
+      to.area - other_area + area <= inputs.max_block_area &&
+      from.area - area + other_area <= inputs.max_block_area;
+  if (legal == false) {
+    return abort_pass();
+  }
+
+  steps.clear();
+  steps.push_back(Step{cell_id, from_block_id, to_block_id});
+  steps.push_back(Step{other_id, to_block_id, from_block_id});
+  return decide_steps(inputs);
+}
+
+SimAnneal::PassResult SimAnneal::perform_cluster_move(
+    const InputData& inputs) {
+  const auto [cell_id, to_block_id] = propose(inputs);
+  const BlockId from_block_id = blocks.block_of(cell_id);
+  const Cell cell = inputs.cells[cell_id];
+  if (from_block_id == to_block_id || cell.empty()) {
+    return abort_pass();
+  }
+
+  steps.clear();
+  steps.push_back(Step{cell_id, from_block_id, to_block_id});
+  size_t area = inputs.cell_areas[cell_id];
+
+  // Gather cells of the same block along a random net of the cell, scanning
+  // from a random pin so that large nets yield different clusters
+  const Net net = inputs.nets[cell[random.index(cell.size())]];
+  const size_t offset = random.index(net.size());
+  const size_t nscanned = std::min(net.size(), config::cluster_scan_limit);
+  for (size_t i = 0;
+       i < nscanned && steps.size() < config::max_cluster_size; i += 1) {
+    const CellId other_id = net[(offset + i) % net.size()];
+    if (other_id != cell_id && blocks.block_of(other_id) == from_block_id) {
+      steps.push_back(Step{other_id, from_block_id, to_block_id});
+      area += inputs.cell_areas[other_id];
+    }
+  }
+
+  if (blocks[to_block_id].area + area > inputs.max_block_area) {
+    return abort_pass();
+  }
+  return decide_steps(inputs);
+}
+
+SimAnneal::PassResult SimAnneal::decide_steps(const InputData& inputs) {
+  // Apply the steps to get the exact change in cost, since the deltas of
+  // cells sharing nets are not independent
+  Cost cost_delta = 0;
+  for (const Step& step : steps) {
+    cost_delta += apply_move(step.cell_id, step.from_block_id,
+                             step.to_block_id, inputs);
+  }
+
+  if (acceptance(cost_delta, temp, is_temp_fixed, random.zero_to_one()) ==
+      false) {
+    for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+      apply_move(it->cell_id, it->to_block_id, it->from_block_id, inputs);
+    }
+    return {PassStatus::UphillReject, 0, cost_delta, temp, temp_factor(),
+            clock.now()};
+  }
+
+  cost += cost_delta;
+  nmoves += 1;
+  for (const Step& step : steps) {
+    log_move(step.cell_id, step.from_block_id);
+    if (auditor != nullptr) {
+      audit_step(step.cell_id, step.from_block_id, step.to_block_id,
+                 &step == &steps.back());
+    }
+  }
+  update_best();
+  cool();
+
+  return PassResult{PassStatus::Success, cost, cost_delta, temp,
+                    temp_factor(), clock.now()};
+}
+
+void SimAnneal::submit_audit() {
+  if (auditor->is_idle() == false) {
+    return;
+  }
+
+  AuditSnapshot snapshot;
+  snapshot.nmoves = nmoves;
+  snapshot.cost = cost;
+  snapshot.block_of_cell = blocks.block_of_cells();
+  for (BlockId block_id = 0; block_id < blocks.size(); block_id += 1) {
+    snapshot.block_areas.push_back(blocks[block_id].area);
+    snapshot.block_sizes.push_back(blocks[block_id].cells.size());
+  }
+  snapshot.span_of_net = span_of_net;
+  snapshot.bindings = bindings;
+  snapshot.steps = std::move(audited_steps);
+  audited_steps.clear();
+  audited_nmoves = nmoves;
+  auditor->submit(std::move(snapshot));
+}
+
+void SimAnneal::snapshot_best() {
+  best_block_of_cell = blocks.block_of_cells();
+  for (auto it = moves_since_best.rbegin(); it != moves_since_best.rend();
+       ++it) {
+    best_block_of_cell[it->cell_id] = it->from_block_id;
+  }
+  moves_since_best.clear();
+}
+
+void SimAnneal::speculate(const InputData& inputs, WorkerPool& pool) {
+  // Conflicts are only counted in concurrent batches, so serial batches are
+  // followed by a concurrent one now and then to find out whether they are
+  // still too many
+  if (is_batch_parallel) {
+    is_batch_parallel = static_cast<double>(nconflicts) <=
+                        config::speculative_max_conflict_ratio *
+                            static_cast<double>(speculations.size());
+  } else {
+    nserial_batches += 1;
+    is_batch_parallel = nserial_batches >= config::speculative_serial_batches;
+  }
+  if (is_batch_parallel) {
+    nserial_batches = 0;
+  }
+
+  speculations.resize(config::speculative_batch_size);
+  for (Speculation& speculation : speculations) {
+    std::tie(speculation.cell_id, speculation.to_block_id) = propose(inputs);
+    speculation.from_block_id = blocks.block_of(speculation.cell_id);
+    speculation.draw = random.zero_to_one();
+    speculation.is_evaluated = false;
+  }
+
+  cell_stamp.resize(inputs.ncells, 0);
+  batch_stamp += 1;
+  is_batch_dirty = false;
+  nconflicts = 0;
+
+  if (is_batch_parallel == false) {
+    return;
+  }
+  pool.parallel_for(speculations.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += 1) {
+      Speculation& speculation = speculations[i];
+      if (speculation.from_block_id != speculation.to_block_id) {
+        speculation.cost_delta =
+            cost_delta_of(speculation.cell_id, speculation.from_block_id,
+                          speculation.to_block_id, inputs);
+        speculation.is_evaluated = true;
+      }
+    }
+  });
+}
+
+void SimAnneal::populate_span_of_net(const InputData& inputs) {
+  vector<set<BlockId>> blocks_of_net(inputs.nnets);
+  for (const auto& [block_id, block] : blocks | enumerate) {
+    for (const CellId cell_id : block.cells) {
+      for (const NetId net_id : inputs.cells[cell_id]) {
+        blocks_of_net.at(net_id).insert(block_id);
+      }
+    }
+  }
+
+  // Transform blocks_of_net to span sizes
+  span_of_net = blocks_of_net | transform([](const set<BlockId>& bs) {
+                  return narrow<Cost>(bs.size());
+                }) |
+                to<vector<Cost>>();
+}
+
+void SimAnneal::populate_bindings(const InputData& inputs) {
+  for (const auto& [block_id, block] : blocks | enumerate) {
+    for (const CellId cell_id : block.cells) {
+      const Cell cell = inputs.cells[cell_id];
+      for (const NetId net_id : cell) {
+        bindings.increment(net_id, block_id);
+      }
+    }
+  }
+}
+
+void ProgressReporter::print(const SimAnneal::PassResult& res, size_t chain_id,
+                             double pass_per_sec) {
+  const double opt_rate =
+      static_cast<double>(res.cost) / static_cast<double>(init_cost) * 100.0;
+
+  const std::lock_guard<std::mutex> lock(print_mutex);
+  if (chains.size() > 1) {
+    fmt::print("Chain {:>3}  |  ", chain_id);
+  }
+  fmt::print(
+      "Cost {:>10}  |  Opt {:<7.3}%  |  Elapsed {:%H:%M:%S}  |  Temp "
+      "{:<12.9}  |  TempFactor "
+      "{:<12.9}  |  PassPerSec {:<12.9}\n",
+      res.cost, opt_rate, res.time - begin_time, res.temp,
+      res.temp_factor, pass_per_sec);
+  fflush(stdout);
+}
+
+void ProgressReporter::submit_record(Chain& chain) {
+  telemetry->submit(chain.record);
+  chain.record.counters = TelemetryCounters{};
+  chain.last_record_time = chain.record.time;
+}
+
+void print_move_stats(const SimAnneal& sim_anneal, size_t chain_id) {
+  constexpr const char* names[SimAnneal::nmove_kinds] = {"single", "swap",
+                                                         "cluster"};
+  for (size_t kind = 0; kind < SimAnneal::nmove_kinds; kind += 1) {
+    const SimAnneal::MoveStats& stats = sim_anneal.get_move_stats()[kind];
+    const int64_t nproposed =
+        stats.naccepted + stats.naborted + stats.nrejected;
+    if (nproposed == 0) {
+      continue;
+    }
+    const auto percent = [&](int64_t n) {
+      return 100.0 * static_cast<double>(n) / static_cast<double>(nproposed);
+    };
+    fmt::print(
+        "Chain {} {:>7} moves: {} proposed, {:.1f}% accepted, {:.1f}% "
+        "aborted, {:.1f}% rejected\n",
+        chain_id, names[kind], nproposed, percent(stats.naccepted),
+        percent(stats.naborted), percent(stats.nrejected));
+  }
+}
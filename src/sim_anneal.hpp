@@ -0,0 +1,749 @@
+#ifndef SIM_ANNEAL_HPP_
+#define SIM_ANNEAL_HPP_
+
+#include "acceptance.hpp"
+#include "audit.hpp"
+#include "bindings.hpp"
+#include "boundary_cells.hpp"
+#include "config.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+#include "indexed_blocks.hpp"
+#include "pass_clock.hpp"
+#include "random.hpp"
+#include "telemetry.hpp"
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+template <typename T>
+constexpr T sqr(T t) noexcept {
+  return t * t;
+}
+
+// Auto-adapting temperature factor that approaches `temp_limit` at the end of
+// `budget`, i.e. at its time limit or after its number of moves, whichever
+// comes first.
+class TempFactor {
+ public:
+  TempFactor(const Budget& budget, double init_temp)
+      : temp_factor(config::default_init_temp_factor),
+        time_limit(budget.time_limit),
+        max_moves(budget.max_moves),
+        update_interval(
+            std::min<std::chrono::steady_clock::duration>(
+                config::temp_factor_update_interval,
+                time_limit / config::min_temp_factor_updates)),
+        last_update_time(std::chrono::steady_clock::now()) {
+    // With a move budget the schedule is known before any time has passed
+    if (max_moves > 0) {
+      temp_factor = std::pow(config::temp_limit / init_temp,
+                             1.0 / static_cast<double>(max_moves));
+    }
+  }
+
+  // Gets the factor.
+  double operator()() const { return temp_factor; }
+
+  // Progress of the schedule, kept in checkpoints.
+  struct State {
+    double temp_factor;
+    int64_t moves;
+  };
+
+  State get_state() const { return State{temp_factor, moves}; }
+
+  void restore(const State& state) {
+    temp_factor = state.temp_factor;
+    moves = state.moves;
+  }
+
+  // Updates the factor. This should be called every time when a pass is
+  // performed, with `now` being the current time.
+  void update(std::chrono::steady_clock::time_point now,
+              std::chrono::steady_clock::time_point begin_time,
+              double current_temp) {
+    passes += 1;
+    moves += 1;
+    const auto elapsed = now - last_update_time;
+    if (elapsed <= update_interval) {
+      return;
+    }
+
+    const auto remaining_time = time_limit - (now - begin_time);
+    const double remain_secs =
+        std::chrono::duration<double>(remaining_time).count();
+    const double passes_per_sec =
+        static_cast<double>(passes) /
+        std::chrono::duration<double>(elapsed).count();
+    double remain_passes = remain_secs * passes_per_sec;
+    if (max_moves > 0) {
+      remain_passes =
+          std::min(remain_passes, static_cast<double>(max_moves - moves));
+    }
+
+    temp_factor =
+        std::pow(config::temp_limit / current_temp, 1.0 / remain_passes);
+
+    // Correct factor if it goes crazy
+    if (temp_factor <= 0.0) {
+      temp_factor = config::default_init_temp_factor;
+    }
+
+    passes = 0;
+    last_update_time = now;
+  }
+
+ private:
+  double temp_factor;
+  std::chrono::steady_clock::duration time_limit;
+  int64_t max_moves;
+
+  // Short time limits get more frequent updates, so that they still cool down
+  std::chrono::steady_clock::duration update_interval;
+
+  std::chrono::steady_clock::time_point last_update_time;
+  int64_t passes = 0;
+  int64_t moves = 0;
+};
+
+// Simulated annealing over partitions with a fixed number of blocks, with
+// incrementally maintained cost.
+class SimAnneal {
+ public:
+  SimAnneal(const std::vector<Block>& blocks, const InputData& inputs,
+            Cost init_cost, uint64_t seed,
+            std::chrono::steady_clock::time_point begin_time =
+                std::chrono::steady_clock::now(),
+            const Budget& budget = Budget{},
+            double init_temp = config::default_init_temp,
+            const AnnealOptions& options = AnnealOptions{});
+
+  // State of a chain from which it can be resumed.
+  struct Checkpoint {
+    size_t nblocks = 0;
+    std::vector<BlockId> block_of_cell;
+    std::vector<BlockId> best_block_of_cell;
+    Cost cost = 0;
+    Cost best_cost = 0;
+    double temp = 0.0;
+    bool is_temp_fixed = false;
+    TempFactor::State temp_factor{};
+    Random random{0, 0, 0};
+    int64_t nmoves = 0;
+    int64_t nstall_passes = 0;
+
+    // Time spent by the chain up to the checkpoint
+    std::chrono::steady_clock::duration elapsed{};
+  };
+
+  // Resumes a chain from `checkpoint`.  The time spent before the checkpoint
+  // counts as spent before `begin_time`, so the chain continues with the rest
+  // of `budget`.
+  SimAnneal(const Checkpoint& checkpoint, const InputData& inputs,
+            std::chrono::steady_clock::time_point begin_time,
+            const Budget& budget, const AnnealOptions& options);
+
+  // Takes a checkpoint of the current state.
+  Checkpoint take_checkpoint() const;
+
+  // Whether any limit of the budget has been reached.
+  bool should_terminate() const {
+    if (budget.max_moves > 0 && nmoves >= budget.max_moves) {
+      return true;
+    }
+    if (budget.max_stall_passes > 0 &&
+        nstall_passes >= budget.max_stall_passes) {
+      return true;
+    }
+    if (auditor != nullptr && auditor->has_failed()) {
+      return true;
+    }
+    const bool is_time_over = clock.now() - begin_time > budget.time_limit;
+    return is_time_over;
+  }
+
+  enum class PassStatus {
+    Success,
+    Abort,
+    UphillReject,
+  };
+
+  struct PassResult {
+    PassStatus status;
+    Cost cost;
+    Cost cost_delta;
+    double temp;
+    double temp_factor;
+
+    // Time of the pass, as last read by the pass clock
+    std::chrono::steady_clock::time_point time;
+  };
+
+  // Kinds of moves, mixed by `AnnealOptions`
+  enum class MoveKind {
+    // A cell to another block
+    Single,
+    // Two cells of different blocks exchanging their blocks
+    Swap,
+    // A few cells of a net in the same block to another block
+    Cluster,
+  };
+  static constexpr size_t nmove_kinds = 3;
+
+  // Outcomes of the passes of a kind of moves
+  struct MoveStats {
+    int64_t naccepted = 0;
+    int64_t naborted = 0;
+    int64_t nrejected = 0;
+  };
+
+  PassResult perform_pass(const InputData& inputs) {
+    begin_pass();
+
+    if (is_mixing_moves) {
+      const double kind_draw = random.zero_to_one();
+      if (kind_draw < swap_ratio) {
+        return count(MoveKind::Swap, perform_swap(inputs));
+      }
+      if (kind_draw < swap_ratio + cluster_ratio) {
+        return count(MoveKind::Cluster, perform_cluster_move(inputs));
+      }
+    }
+
+    const auto [cell_id, to_block_id] = propose(inputs);
+    const BlockId from_block_id = blocks.block_of(cell_id);
+
+    if (is_legal_move(cell_id, from_block_id, to_block_id, inputs) == false) {
+      return count(MoveKind::Single, abort_pass());
+    }
+
+    const Cost cost_delta =
+        cost_delta_of(cell_id, from_block_id, to_block_id, inputs);
+    return count(MoveKind::Single,
+                 decide(cell_id, from_block_id, to_block_id, cost_delta,
+                        random.zero_to_one(), inputs));
+  }
+
+  // Performs up to `config::speculative_batch_size` passes, stopping early if
+  // `should_terminate`, and calls `on_result` with the result of each.
+  //
+  // The proposals of all of the passes are drawn first, and evaluated
+  // concurrently on `pool` against the current state.  They are then
+  // committed in order, re-evaluating those whose nets have been touched by
+  // moves committed earlier in the batch, so that the chain is the same as if
+  // the proposals were evaluated one by one.  When most proposals conflict,
+  // as at high temperatures, evaluation is left to the committer for the next
+  // `config::speculative_serial_batches` batches instead.
+  template <typename F>
+  void perform_speculative_passes(const InputData& inputs, WorkerPool& pool,
+                                  F&& on_result) {
+    speculate(inputs, pool);
+    for (Speculation& speculation : speculations) {
+      if (should_terminate()) {
+        return;
+      }
+      on_result(commit(speculation, inputs));
+    }
+  }
+
+  // Gets the outcomes of the passes so far, indexed by `MoveKind`.
+  const std::array<MoveStats, nmove_kinds>& get_move_stats() const {
+    return move_stats;
+  }
+
+  Cost get_cost() const { return cost; }
+  Cost get_best_cost() const { return best_cost; }
+  double get_temp() const { return temp; }
+
+  // Pins the temperature at `fixed_temp`, which disables cooling.
+  void fix_temp(double fixed_temp) {
+    temp = fixed_temp;
+    is_temp_fixed = true;
+  }
+
+  // Gets the resulting blocks and destroys it.
+  // It is not allowed to do anything with this instance of `SimAnneal` after
+  // calling this method.
+  std::vector<Block> into_blocks() { return blocks.into_blocks(); }
+
+  // Gets the blocks of the lowest cost seen so far and destroys it, like
+  // `into_blocks`.
+  std::vector<Block> into_best_blocks(const InputData& inputs);
+
+ private:
+  // Blocks and CellId -> BlockId
+  IndexedBlocks blocks;
+
+  // (NetId, BlockId) -> Int (#cells of net in block)
+  Bindings bindings;
+
+  // NetId -> Int (#blocks spanned by net)
+  std::vector<Cost> span_of_net;
+
+  Cost cost;
+  double temp;
+  bool is_temp_fixed = false;
+  TempFactor temp_factor;
+  Random random;
+  Acceptance acceptance;
+
+  // Boundary cells, maintained only for connected proposals
+  ProposalMode proposal_mode;
+  BoundaryCells boundary_cells;
+
+  // Mix of move kinds, with single moves taking the rest
+  bool is_mixing_moves;
+  double swap_ratio;
+  double cluster_ratio;
+  std::array<MoveStats, nmove_kinds> move_stats{};
+
+  // A cell moving in a move of several cells
+  struct Step {
+    CellId cell_id;
+    BlockId from_block_id;
+    BlockId to_block_id;
+  };
+
+  // Steps of the current move of several cells
+  std::vector<Step> steps;
+
+  PassClock clock;
+  std::chrono::steady_clock::time_point begin_time;
+  Budget budget;
+
+  // Number of accepted moves
+  int64_t nmoves = 0;
+
+  // Checker of the incremental state, if audits are enabled, and the steps
+  // of the moves accepted since the last audit
+  int64_t audit_interval;
+  int64_t audited_nmoves = 0;
+  std::unique_ptr<Auditor> auditor;
+  std::vector<AuditedStep> audited_steps;
+
+  // Number of passes at `temp_limit` since the best cost was last lowered
+  int64_t nstall_passes = 0;
+
+  // An accepted move, recorded for undoing it.
+  struct Move {
+    uint32_t cell_id;
+    uint32_t from_block_id;
+  };
+
+  // The best state is kept either as the moves accepted since reaching it,
+  // which are undone to restore it, or as a snapshot of its cell-to-block
+  // mapping once the log grows too long.  At most one of the two is
+  // non-empty.
+  Cost best_cost;
+  std::vector<Move> moves_since_best;
+  std::vector<BlockId> best_block_of_cell;
+
+  // A proposed move, evaluated speculatively
+  struct Speculation {
+    CellId cell_id;
+    BlockId from_block_id;
+    BlockId to_block_id;
+    double draw;
+    Cost cost_delta;
+    bool is_evaluated;
+  };
+
+  // Proposals of the current speculative batch
+  std::vector<Speculation> speculations;
+
+  // CellId -> `batch_stamp` if a move committed in the current batch touched
+  // any net of the cell.  Only kept up to date while the batch is evaluated
+  // concurrently, since the committer evaluates every proposal otherwise.
+  std::vector<uint32_t> cell_stamp;
+  uint32_t batch_stamp = 0;
+  bool is_batch_dirty = false;
+
+  // Whether the current batch was evaluated concurrently, and the number of
+  // batches since one was
+  bool is_batch_parallel = true;
+  size_t nserial_batches = 0;
+
+  // Number of proposals of the current batch that needed re-evaluation
+  size_t nconflicts = 0;
+
+  // Draws a cell and the block to move it to.
+  std::pair<CellId, BlockId> propose(const InputData& inputs) {
+    if (proposal_mode == ProposalMode::Uniform || boundary_cells.empty() ||
+        random.zero_to_one() < config::uniform_proposal_ratio) {
+      const CellId cell_id = random.cell_id();
+      return {cell_id, random.block_id()};
+    }
+
+    // Move a boundary cell to the block of a random pin of one of its nets,
+    // which favours blocks holding many of its pins
+    const CellId cell_id = boundary_cells[random.index(boundary_cells.size())];
+    const BlockId from_block_id = blocks.block_of(cell_id);
+    const Cell cell = inputs.cells[cell_id];
+    for (int i = 0; i < config::connected_proposal_tries; i += 1) {
+      const Net net = inputs.nets[cell[random.index(cell.size())]];
+      const CellId pin_id = net[random.index(net.size())];
+      const BlockId to_block_id = blocks.block_of(pin_id);
+      if (to_block_id != from_block_id) {
+        return {cell_id, to_block_id};
+      }
+    }
+    return {cell_id, from_block_id};
+  }
+
+  PassResult count(MoveKind kind, const PassResult& res) {
+    MoveStats& stats = move_stats[static_cast<size_t>(kind)];
+    switch (res.status) {
+      case PassStatus::Success:
+        stats.naccepted += 1;
+        break;
+      case PassStatus::Abort:
+        stats.naborted += 1;
+        break;
+      case PassStatus::UphillReject:
+        stats.nrejected += 1;
+        break;
+    }
+    return res;
+  }
+
+  PassResult abort_pass() const {
+    return {PassStatus::Abort, 0, 0, temp, temp_factor(), clock.now()};
+  }
+
+  void begin_pass() {
+    clock.tick();
+    if (temp <= config::temp_limit && is_temp_fixed == false) {
+      nstall_passes += 1;
+    }
+  }
+
+  bool is_legal_move(CellId cell_id, BlockId from_block_id,
+                     BlockId to_block_id, const InputData& inputs) const {
+    const bool legal = blocks[to_block_id].area + inputs.cell_areas[cell_id] <=
+                       inputs.max_block_area;
+    const bool is_not_move = from_block_id == to_block_id;
+    return legal == true && is_not_move == false;
+  }
+
+  // Calculates the change in cost of moving a cell.  Reads the state only.
+  Cost cost_delta_of(CellId cell_id, BlockId from_block_id,
+                     BlockId to_block_id, const InputData& inputs) const {
+    Cost cost_delta = 0;
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      int span_delta = 0;
+      if (bindings.get(net_id, from_block_id) == 1) {
+        // after moving cell away, net will no longer be spanning the block
+        span_delta -= 1;
+      }
+
+      if (bindings.get(net_id, to_block_id) == 0) {
+        // after moving cell in, net will now be (newly) spanning the block
+        span_delta += 1;
+      }
+
+      const Cost old_span = span_of_net[net_id];
+      const Cost new_span = old_span + span_delta;
+
+      cost_delta += sqr(new_span - 1) - sqr(old_span - 1);
+    }
+    return cost_delta;
+  }
+
+  // Accepts or rejects a legal move of `cost_delta` given the uniform draw
+  // `draw`, and applies it if accepted.
+  PassResult decide(CellId cell_id, BlockId from_block_id, BlockId to_block_id,
+                    Cost cost_delta, double draw, const InputData& inputs) {
+    // determine to accept or reject
+    const bool is_accepted =
+        acceptance(cost_delta, temp, is_temp_fixed, draw);
+    if (is_accepted == false) {
+      return {PassStatus::UphillReject, 0, cost_delta, temp, temp_factor(),
+              clock.now()};
+    }
+
+    // accepted; update records
+    cost += cost_delta;
+    nmoves += 1;
+    apply_move(cell_id, from_block_id, to_block_id, inputs);
+    if (auditor != nullptr) {
+      audit_step(cell_id, from_block_id, to_block_id, true);
+    }
+    log_move(cell_id, from_block_id);
+    update_best();
+    cool();
+
+    return PassResult{PassStatus::Success, cost, cost_delta, temp,
+                      temp_factor(), clock.now()};
+  }
+
+  // Moves a cell, updating the bookkeeping but not `cost`, and returns the
+  // change in cost.
+  Cost apply_move(CellId cell_id, BlockId from_block_id, BlockId to_block_id,
+                  const InputData& inputs) {
+    Cost cost_delta = 0;
+    for (const NetId net_id : inputs.cells[cell_id]) {
+      int span_delta = 0;
+      if (bindings.get(net_id, from_block_id) == 1) {
+        // after moving cell away, net will no longer be spanning the block
+        span_delta -= 1;
+      }
+      bindings.decrement(net_id, from_block_id);
+
+      if (bindings.get(net_id, to_block_id) == 0) {
+        // after moving cell in, net will now be (newly) spanning the block
+        span_delta += 1;
+      }
+      bindings.increment(net_id, to_block_id);
+
+      if (span_delta != 0) {
+        const Cost old_span = span_of_net[net_id];
+        const Cost new_span = old_span + span_delta;
+        span_of_net[net_id] = new_span;
+        cost_delta += sqr(new_span - 1) - sqr(old_span - 1);
+        if (proposal_mode == ProposalMode::Connected) {
+          boundary_cells.update(net_id, old_span, new_span, inputs);
+        }
+      }
+    }
+
+    // Move the cell
+    blocks.move(cell_id, to_block_id, inputs.cell_areas[cell_id]);
+    return cost_delta;
+  }
+
+  // Logs a step of an accepted move, and audits the state after the last step
+  // once `audit_interval` moves have been accepted since the last audit.
+  void audit_step(CellId cell_id, BlockId from_block_id, BlockId to_block_id,
+                  bool ends_move) {
+    audited_steps.push_back(
+        AuditedStep{cell_id, from_block_id, to_block_id, ends_move, cost});
+    if (ends_move && nmoves - audited_nmoves >= audit_interval) {
+      submit_audit();
+    }
+  }
+
+  // Hands a snapshot to `auditor` unless it is still checking the previous
+  // one.
+  void submit_audit();
+
+  // Updates and clamps temperature after an accepted move.
+  void cool() {
+    if (is_temp_fixed == false) {
+      temp *= temp_factor();
+      temp = std::clamp(temp, config::temp_limit, config::temp_limit_top);
+
+      temp_factor.update(clock.now(), begin_time, temp);
+    }
+  }
+
+  // Swaps a cell with a random cell of the block it is proposed to move to.
+  PassResult perform_swap(const InputData& inputs);
+
+  // Moves a cell together with a few cells sharing one of its nets and its
+  // block.
+  PassResult perform_cluster_move(const InputData& inputs);
+
+  // Applies `steps`, and accepts or reverts them as a single move.
+  PassResult decide_steps(const InputData& inputs);
+
+  // Draws the proposals of a speculative batch, and evaluates them on `pool`
+  // unless the previous batch had too many conflicts.
+  void speculate(const InputData& inputs, WorkerPool& pool);
+
+  // Commits a speculatively evaluated proposal as a pass.
+  PassResult commit(Speculation& speculation, const InputData& inputs) {
+    begin_pass();
+
+    const CellId cell_id = speculation.cell_id;
+    const BlockId from_block_id = blocks.block_of(cell_id);
+    const BlockId to_block_id = speculation.to_block_id;
+
+    // The evaluation is stale if a committed move touched any of the nets,
+    // including by moving the cell itself
+    const bool is_stale = is_batch_parallel && is_batch_dirty &&
+                          cell_stamp[cell_id] == batch_stamp;
+    if (is_stale) {
+      nconflicts += 1;
+    }
+
+    if (is_legal_move(cell_id, from_block_id, to_block_id, inputs) == false) {
+      return count(MoveKind::Single, abort_pass());
+    }
+
+    if (is_stale || speculation.is_evaluated == false) {
+      speculation.cost_delta =
+          cost_delta_of(cell_id, from_block_id, to_block_id, inputs);
+    }
+    const PassResult res = count(
+        MoveKind::Single,
+        decide(cell_id, from_block_id, to_block_id, speculation.cost_delta,
+               speculation.draw, inputs));
+
+    // Accepted moves are rare where speculation pays off, so marking every
+    // neighbour here is cheaper than checking every net of each proposal
+    if (is_batch_parallel && res.status == PassStatus::Success) {
+      for (const NetId net_id : inputs.cells[cell_id]) {
+        for (const CellId other_id : inputs.nets[net_id]) {
+          cell_stamp[other_id] = batch_stamp;
+        }
+      }
+      cell_stamp[cell_id] = batch_stamp;
+      is_batch_dirty = true;
+    }
+    return res;
+  }
+
+  void populate_span_of_net(const InputData& inputs);
+  void populate_bindings(const InputData& inputs);
+
+  // Logs a moved cell for restoring the best state.
+  void log_move(CellId cell_id, BlockId from_block_id) {
+    if (best_block_of_cell.empty() == false) {
+      return;
+    }
+    moves_since_best.push_back(
+        Move{static_cast<uint32_t>(cell_id),
+             static_cast<uint32_t>(from_block_id)});
+  }
+
+  // Updates the best state after the cells of an accepted move are logged.
+  void update_best() {
+    if (cost < best_cost) {
+      best_cost = cost;
+      nstall_passes = 0;
+      moves_since_best.clear();
+      best_block_of_cell.clear();
+      return;
+    }
+
+    // Taking the snapshot costs O(ncells), so it is amortized over at least
+    // as many moves
+    if (moves_since_best.size() >= max_logged_moves) {
+      snapshot_best();
+    }
+  }
+
+  // Replaces the move log with a snapshot of the best state.
+  void snapshot_best();
+
+  size_t max_logged_moves;
+};
+
+// Prints the outcomes of the passes of each kind of moves proposed by a chain.
+void print_move_stats(const SimAnneal& sim_anneal, size_t chain_id);
+
+// Progress printer shared by all of the SA chains.
+// Each chain only touches its own counters, and takes the lock only to print.
+class ProgressReporter {
+ public:
+  // Also writes telemetry records of every chain to `telemetry`, if any.
+  ProgressReporter(Cost init_cost, size_t nchains = 1,
+                   std::shared_ptr<TelemetrySink> telemetry = nullptr)
+      : chains(nchains),
+        begin_time(std::chrono::steady_clock::now()),
+        init_cost(init_cost),
+        telemetry(std::move(telemetry)) {
+    for (size_t chain_id = 0; chain_id < nchains; chain_id += 1) {
+      chains[chain_id].record.chain_id = chain_id;
+      chains[chain_id].record.cost = init_cost;
+      chains[chain_id].record.best_cost = init_cost;
+    }
+  }
+
+  // Updates value stored in the reporter for chain `chain_id` with the result
+  // of a pass.  If elapsed time since last print is long enough, print out
+  // info.  Concurrent calls must have different `chain_id`s.
+  void update(const SimAnneal::PassResult& res, size_t chain_id = 0) {
+    Chain& chain = chains[chain_id];
+    if (telemetry != nullptr) {
+      count(res, chain);
+    }
+    if (res.status != SimAnneal::PassStatus::Success) {
+      return;
+    }
+    chain.num_success += 1;
+
+    const auto elapsed = res.time - chain.last_update_time;
+    if (elapsed <= config::report_interval) {
+      return;
+    }
+
+    print(res, chain_id,
+          static_cast<double>(chain.num_success) /
+              std::chrono::duration<double>(elapsed).count());
+
+    chain.last_update_time = res.time;
+    chain.num_success = 0;
+  }
+
+  // Writes the telemetry of chain `chain_id` since its last record, if any.
+  // This should be called when the chain ends.
+  void finish(size_t chain_id = 0) {
+    Chain& chain = chains[chain_id];
+    if (telemetry != nullptr && chain.record.counters.nproposals > 0) {
+      submit_record(chain);
+    }
+  }
+
+ private:
+  // Counters of a chain, on its own cache line to avoid false sharing
+  struct alignas(64) Chain {
+    std::chrono::steady_clock::time_point last_update_time =
+        std::chrono::steady_clock::now();
+    int64_t num_success = 0;
+
+    // Telemetry of the current interval, with the state after the last pass
+    std::chrono::steady_clock::time_point last_record_time =
+        std::chrono::steady_clock::now();
+    TelemetryRecord record;
+  };
+
+  void print(const SimAnneal::PassResult& res, size_t chain_id,
+             double pass_per_sec);
+
+  // Counts a pass in the telemetry of `chain`, and submits a record once the
+  // interval is over.
+  void count(const SimAnneal::PassResult& res, Chain& chain) {
+    TelemetryRecord& record = chain.record;
+    switch (res.status) {
+      case SimAnneal::PassStatus::Success:
+        record.counters.count_evaluated(res.cost_delta, true);
+        record.cost = res.cost;
+        record.best_cost = std::min(record.best_cost, res.cost);
+        break;
+      case SimAnneal::PassStatus::Abort:
+        record.counters.count_abort();
+        break;
+      case SimAnneal::PassStatus::UphillReject:
+        record.counters.count_evaluated(res.cost_delta, false);
+        break;
+    }
+    record.time = res.time;
+    record.temp = res.temp;
+    record.temp_factor = res.temp_factor;
+
+    if (res.time - chain.last_record_time > config::telemetry_interval) {
+      submit_record(chain);
+    }
+  }
+
+  // Hands the telemetry record of `chain` to the sink and resets its counters.
+  void submit_record(Chain& chain);
+
+  std::vector<Chain> chains;
+  std::chrono::steady_clock::time_point begin_time;
+  Cost init_cost;
+  std::mutex print_mutex;
+  std::shared_ptr<TelemetrySink> telemetry;
+};
+
+#endif  // SIM_ANNEAL_HPP_
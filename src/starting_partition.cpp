@@ -1,102 +1,155 @@
 #include "starting_partition.hpp"
 
-#include <gsl/gsl>
-#include <range/v3/all.hpp>
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
 
 #include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
 #include <random>
+#include <stdexcept>
+#include <utility>
 
-using ranges::to;
-using ranges::views::enumerate;
-using ranges::views::filter;
-using ranges::views::transform;
-
-using std::optional;
 using std::pair;
 using std::vector;
 
 namespace {
 
-// Deterministic random sampler.
-struct Random {
-  Random(int seed) : gen(seed) {}
+// Gets the cells in random order drawn from `gen`.
+vector<CellId> shuffled_cells(const InputData& inputs, std::mt19937& gen) {
+  vector<CellId> order(inputs.ncells);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), gen);
+  return order;
+}
 
-  // Samples a vector element at random and returns by value.
-  template <typename T>
-  T sample(const std::vector<T>& data) {
-    std::uniform_int_distribution<> dis(
-        0, std::distance(data.begin(), data.end()) - 1);
-    return *std::next(data.begin(), dis(gen));
+// Throws if some cell fits in no block at all.
+void check_cell_areas(const InputData& inputs) {
+  for (const size_t area : inputs.cell_areas) {
+    if (area > inputs.max_block_area) {
+      throw std::runtime_error("Failed to find starting partition");
+    }
   }
-
-  std::mt19937 gen;
-};
-
-// Gets first element out of an (index, block) pair.
-decltype(auto) first(pair<size_t, const Block&> p) { return p.first; }
-
-// Finds indexes of all the blocks with the minimum area.
-vector<size_t> indexes_with_min_area(const vector<Block>& blocks) {
-  // Get min area
-  const size_t min_block_area = ranges::min_element(blocks)->area;
-
-  const auto has_min_area = [min_block_area](const auto& p) {
-    return p.second.area == min_block_area;
-  };
-  return blocks | enumerate | filter(has_min_area) | transform(first) |
-         to<vector<size_t>>();
 }
 
-// Finds an nblocks-way starting partition.
-// Returns nullopt if block area limit is violated.
-optional<vector<Block>> find_starting_partition(const InputData& inputs,
-                                                size_t nblocks) {
+// Packs cells largest first into the least filled block, starting with
+// `min_number_of_blocks()` blocks.  A block is added whenever the cell does
+// not fit in the least filled one, since it then fits in none of them.
+vector<Block> find_balanced_partition(const InputData& inputs, int seed) {
+  std::mt19937 gen(seed);
+  vector<CellId> order = shuffled_cells(inputs, gen);
+  std::stable_sort(order.begin(), order.end(), [&](CellId a, CellId b) {
+    return inputs.cell_areas[a] > inputs.cell_areas[b];
+  });
+
+  // Min-heap of (area, block id)
+  using Entry = pair<size_t, BlockId>;
+  const size_t nblocks = std::max<size_t>(inputs.min_number_of_blocks(), 1);
   vector<Block> blocks(nblocks);
-  constexpr int seed = 42;
-  Random random{seed};
-
-  for (size_t i = 0; i < inputs.ncells; i += 1) {
-    const auto indexes = indexes_with_min_area(blocks);
-
-    // Sample one block and put the cell into it
-    const size_t gi = random.sample(indexes);
-    auto& sampled = blocks[gi];
+  vector<Entry> entries;
+  for (BlockId block_id = 0; block_id < nblocks; block_id += 1) {
+    entries.emplace_back(0, block_id);
+  }
+  std::priority_queue<Entry, vector<Entry>, std::greater<>> heap(
+      std::greater<>{}, std::move(entries));
+
+  for (const CellId cell_id : order) {
+    const size_t area = inputs.cell_areas[cell_id];
+    BlockId block_id = heap.top().second;
+    if (blocks[block_id].area + area > inputs.max_block_area) {
+      block_id = blocks.size();
+      blocks.emplace_back();
+    } else {
+      heap.pop();
+    }
 
-    sampled.cells.push_back(i);
-    sampled.area += inputs.cell_areas[i];
+    blocks[block_id].cells.push_back(cell_id);
+    blocks[block_id].area += area;
+    heap.emplace(blocks[block_id].area, block_id);
+  }
+  return blocks;
+}
 
-    // Return nullopt upon block area violation
-    if (sampled.area > inputs.max_block_area) {
-      return std::nullopt;
+// Gets the cells in breadth-first order over nets of degree at most
+// `config::starting_bfs_max_net_degree`, starting each component at a
+// random cell.
+vector<CellId> bfs_order(const InputData& inputs, int seed) {
+  std::mt19937 gen(seed);
+  const vector<CellId> roots = shuffled_cells(inputs, gen);
+
+  vector<CellId> order;
+  order.reserve(inputs.ncells);
+  vector<bool> is_visited(inputs.ncells, false);
+  for (const CellId root_id : roots) {
+    if (is_visited[root_id]) {
+      continue;
+    }
+    is_visited[root_id] = true;
+
+    // `order` doubles as the queue, with the front at `head`
+    size_t head = order.size();
+    order.push_back(root_id);
+    while (head < order.size()) {
+      const CellId cell_id = order[head];
+      head += 1;
+      for (const NetId net_id : inputs.cells[cell_id]) {
+        const Net net = inputs.nets[net_id];
+        if (net.size() > config::starting_bfs_max_net_degree) {
+          continue;
+        }
+        for (const CellId other_id : net) {
+          if (is_visited[other_id] == false) {
+            is_visited[other_id] = true;
+            order.push_back(other_id);
+          }
+        }
+      }
     }
   }
-
-  return blocks;
+  return order;
 }
 
-size_t next_k(size_t k, size_t ncells) {
-  constexpr double growth = 1.01;
+// Fills blocks one after another with cells in breadth-first order, so that
+// connected cells share blocks.  A block is closed once it reaches the
+// average area of a `min_number_of_blocks()`-way partition, or when the next
+// cell does not fit.
+vector<Block> find_bfs_partition(const InputData& inputs, int seed) {
+  const size_t nblocks = std::max<size_t>(inputs.min_number_of_blocks(), 1);
+  const size_t target_area = (inputs.total_area + nblocks - 1) / nblocks;
+
+  vector<Block> blocks(1);
+  for (const CellId cell_id : bfs_order(inputs, seed)) {
+    const size_t area = inputs.cell_areas[cell_id];
+    const Block& last = blocks.back();
+    const bool is_full = last.area + area > inputs.max_block_area ||
+                         (last.area >= target_area && blocks.size() < nblocks);
+    if (is_full && last.cells.empty() == false) {
+      blocks.emplace_back();
+    }
 
-  size_t k1 = static_cast<size_t>(static_cast<double>(k) * growth);
-  size_t k2 = k + 1;
-  size_t k3 = ncells;
-  size_t next = std::min(std::max(k1, k2), k3);
-  fmt::print("Retry with k = {}\n", next);
-  return next;
+    blocks.back().cells.push_back(cell_id);
+    blocks.back().area += area;
+  }
+  return blocks;
 }
 
 }  // namespace
 
-// Finds an starting partition with unspecified (but legal) #blocks.
-// Throws if it is impossible to partition.
-vector<Block> find_starting_partition(const InputData& inputs) noexcept(false) {
-  for (size_t k = inputs.min_number_of_blocks(); k <= inputs.ncells;
-       k = next_k(k, inputs.ncells)) {
-    if (auto blocks = find_starting_partition(inputs, k)) {
-      fmt::print("Success with {}-way partition\n", k);
-      return *blocks;
-    }
-    fmt::print("Failed to find starting partition with k = {}\n", k);
+vector<Block> find_starting_partition(const InputData& inputs, int seed,
+                                      StartingPartitionMode mode) noexcept(
+    false) {
+  check_cell_areas(inputs);
+
+  vector<Block> blocks;
+  switch (mode) {
+    case StartingPartitionMode::Balanced:
+      blocks = find_balanced_partition(inputs, seed);
+      break;
+    case StartingPartitionMode::Bfs:
+      blocks = find_bfs_partition(inputs, seed);
+      break;
   }
-  throw std::runtime_error("Failed to find starting partition");
+  fmt::print("Success with {}-way partition\n", blocks.size());
+  return blocks;
 }
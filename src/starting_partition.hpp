@@ -1,13 +1,19 @@
 #ifndef STARTING_PARTITION_HPP_
 #define STARTING_PARTITION_HPP_
 
+#include "config.hpp"
 #include "data.hpp"
 
 #include <vector>
 
-// Finds an starting partition with unspecified (but legal) #blocks.
+// Finds an starting partition with unspecified (but legal) #blocks, close to
+// `min_number_of_blocks()`, in O(n log n) time.
+// Ties between cells are broken at random, seeded with `seed`, and ties
+// between blocks go to the block with the lowest id.
 // Throws if it is impossible to partition.
-std::vector<Block> find_starting_partition(const InputData& inputs) noexcept(
-    false);
+std::vector<Block> find_starting_partition(
+    const InputData& inputs, int seed = config::starting_partition_seed,
+    StartingPartitionMode mode =
+        StartingPartitionMode::Balanced) noexcept(false);
 
 #endif  // STARTING_PARTITION_HPP_
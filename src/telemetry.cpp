@@ -0,0 +1,72 @@
+#include "telemetry.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// Formats `record` as a JSON object, with time counted from `begin_time`.
+std::string to_json(const TelemetryRecord& record,
+                    std::chrono::steady_clock::time_point begin_time) {
+  const TelemetryCounters& counters = record.counters;
+  const std::chrono::duration<double> secs = record.time - begin_time;
+  return fmt::format(
+      "{{\"chain\":{},\"time\":{:.3f},\"proposals\":{},\"aborts\":{},"
+      "\"downhill_accepts\":{},\"uphill_accepts\":{},\"rejects\":{},"
+      "\"temp\":{},\"temp_factor\":{},\"cost\":{},\"best_cost\":{},"
+      "\"delta_min\":{},\"delta_counts\":[{}]}}",
+      record.chain_id, secs.count(), counters.nproposals, counters.naborted,
+      counters.ndownhill, counters.nuphill, counters.nrejected, record.temp,
+      record.temp_factor, record.cost, record.best_cost,
+      -config::telemetry_max_delta, fmt::join(counters.delta_counts, ","));
+}
+}  // namespace
+
+TelemetrySink::TelemetrySink(const std::string& path) noexcept(false)
+    : os(path), begin_time(std::chrono::steady_clock::now()) {
+  if (os.is_open() == false) {
+    throw std::runtime_error(
+        fmt::format("Failed to open telemetry output {}", path));
+  }
+  worker = std::thread([this] { work(); });
+}
+
+TelemetrySink::~TelemetrySink() {
+  {
+    std::lock_guard lock{mutex};
+    is_stopping = true;
+  }
+  cv.notify_all();
+  worker.join();
+}
+
+void TelemetrySink::submit(const TelemetryRecord& record) {
+  {
+    std::lock_guard lock{mutex};
+    pending.push_back(record);
+  }
+  cv.notify_all();
+}
+
+void TelemetrySink::work() {
+  std::vector<TelemetryRecord> records;
+  std::unique_lock lock{mutex};
+  while (true) {
+    cv.wait(lock, [this] { return is_stopping || pending.empty() == false; });
+    if (pending.empty()) {
+      return;
+    }
+
+    // Format and write without holding the lock, so that chains can submit
+    std::swap(records, pending);
+    lock.unlock();
+    for (const TelemetryRecord& record : records) {
+      os << to_json(record, begin_time) << '\n';
+    }
+    os.flush();
+    records.clear();
+    lock.lock();
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef TELEMETRY_HPP_
+#define TELEMETRY_HPP_
+
+#include "config.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Cost = std::int64_t;
+
+// Counters of the passes of a chain within a telemetry interval.
+struct TelemetryCounters {
+  // Number of bins of the histogram of cost deltas, with deltas beyond
+  // `config::telemetry_max_delta` counted in the outermost bins
+  static constexpr size_t nbins = 2 * config::telemetry_max_delta + 1;
+
+  int64_t nproposals = 0;
+  int64_t naborted = 0;
+  int64_t ndownhill = 0;
+  int64_t nuphill = 0;
+  int64_t nrejected = 0;
+  std::array<int64_t, nbins> delta_counts{};
+
+  void count_abort() {
+    nproposals += 1;
+    naborted += 1;
+  }
+
+  void count_evaluated(Cost cost_delta, bool is_accepted) {
+    nproposals += 1;
+    if (is_accepted == false) {
+      nrejected += 1;
+    } else if (cost_delta > 0) {
+      nuphill += 1;
+    } else {
+      ndownhill += 1;
+    }
+
+    const Cost max_delta = config::telemetry_max_delta;
+    delta_counts[std::clamp(cost_delta, -max_delta, max_delta) + max_delta] +=
+        1;
+  }
+};
+
+// Telemetry of a chain over an interval, with its state at the end.
+struct TelemetryRecord {
+  size_t chain_id = 0;
+  std::chrono::steady_clock::time_point time;
+  double temp = 0.0;
+  double temp_factor = 0.0;
+  Cost cost = 0;
+  Cost best_cost = 0;
+  TelemetryCounters counters;
+};
+
+// Destination of telemetry records, shared by all chains of a run.  Each
+// record is written as a JSON object on a line of its own by a background
+// thread, so that a slow reader never blocks the chains.
+class TelemetrySink {
+ public:
+  // Opens the file or pipe at `path` for writing.  Throws if it cannot be
+  // opened.
+  explicit TelemetrySink(const std::string& path) noexcept(false);
+
+  // Writes out the records submitted so far before closing.
+  ~TelemetrySink();
+
+  TelemetrySink(const TelemetrySink&) = delete;
+  TelemetrySink& operator=(const TelemetrySink&) = delete;
+
+  // Queues `record` for writing.  Safe to call from any thread.
+  void submit(const TelemetryRecord& record);
+
+ private:
+  void work();
+
+  std::ofstream os;
+  std::chrono::steady_clock::time_point begin_time;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<TelemetryRecord> pending;
+  bool is_stopping = false;
+
+  std::thread worker;
+};
+
+#endif  // TELEMETRY_HPP_
@@ -0,0 +1,166 @@
+#include "tempering.hpp"
+#include "config.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+#include "random.hpp"
+#include "sim_anneal.hpp"
+#include "worker_pool.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+using gsl::narrow_cast;
+using std::vector;
+using std::chrono::steady_clock;
+
+namespace {
+// Gets the temperatures of `nslots` slots at `fraction` of the time limit.
+// The ladder cools geometrically from `config::default_init_temp` down to
+// `config::temp_limit` at the coldest slot, like the schedule of SA, while
+// hotter slots stay a constant ratio above it, up to
+// `config::tempering_ladder_ratio` at the hottest.
+vector<double> make_ladder(size_t nslots, double fraction) {
+  const double coldest =
+      config::default_init_temp *
+      std::pow(config::temp_limit / config::default_init_temp,
+               std::clamp(fraction, 0.0, 1.0));
+  vector<double> ladder(nslots, coldest);
+  for (size_t slot = 1; slot < nslots; slot += 1) {
+    ladder[slot] =
+        coldest * std::pow(config::tempering_ladder_ratio,
+                           static_cast<double>(slot) /
+                               static_cast<double>(nslots - 1));
+  }
+  return ladder;
+}
+
+// Runs one epoch of a replica, stopping early at the time limit.
+void run_epoch(SimAnneal& replica, const InputData& inputs,
+               ProgressReporter& reporter, size_t replica_id) {
+  for (int64_t i = 0; i < config::tempering_epoch_passes; i += 1) {
+    if (replica.should_terminate()) {
+      return;
+    }
+    reporter.update(replica.perform_pass(inputs), replica_id);
+  }
+}
+}  // namespace
+
+vector<Block> perform_tempering_partition(const vector<Block>& blocks,
+                                          const InputData& inputs,
+                                          Cost init_cost,
+                                          const Config& config) {
+  const steady_clock::time_point begin_time = steady_clock::now();
+  const size_t nreplicas = config.nthreads > 1
+                               ? config.nthreads
+                               : config::default_tempering_replicas;
+  const size_t nthreads = std::clamp<size_t>(config.nthreads, 1, nreplicas);
+  fmt::print("Tempering with {} replicas on {} threads\n", nreplicas,
+             nthreads);
+
+  SeedSource next_seed{config.seed};
+  vector<SimAnneal> replicas;
+  replicas.reserve(nreplicas);
+  for (size_t replica_id = 0; replica_id < nreplicas; replica_id += 1) {
+    replicas.emplace_back(blocks, inputs, init_cost, next_seed(), begin_time,
+                          config.budget, config::default_init_temp,
+                          config.anneal);
+  }
+
+  // Slot (index into the ladder) -> index of the replica at that temperature.
+  // Exchanging temperatures only permutes this, so no state is ever copied.
+  vector<size_t> replica_of_slot(nreplicas);
+  std::iota(replica_of_slot.begin(), replica_of_slot.end(), 0);
+
+  ProgressReporter reporter{init_cost, nreplicas, config.telemetry};
+  Xoshiro256pp gen(next_seed());
+  std::uniform_real_distribution<double> zero_one_gen(0.0, 1.0);
+
+  // Swap attempts and accepts between slot `i` and `i + 1`
+  vector<int64_t> nattempts(nreplicas, 0);
+  vector<int64_t> naccepts(nreplicas, 0);
+
+  // Each thread of the pool runs the epochs of a contiguous range of replicas
+  WorkerPool pool{nthreads};
+  vector<std::exception_ptr> errors(nreplicas);
+  const auto run_epochs = [&](size_t begin, size_t end) {
+    for (size_t replica_id = begin; replica_id < end; replica_id += 1) {
+      try {
+        run_epoch(replicas[replica_id], inputs, reporter, replica_id);
+      } catch (...) {
+        errors[replica_id] = std::current_exception();
+      }
+    }
+  };
+  const auto is_terminated = [](const SimAnneal& replica) {
+    return replica.should_terminate();
+  };
+
+  vector<double> ladder;
+  size_t parity = 0;
+  while (std::all_of(replicas.begin(), replicas.end(), is_terminated) ==
+         false) {
+    const std::chrono::duration<double> elapsed =
+        steady_clock::now() - begin_time;
+    ladder = make_ladder(
+        nreplicas,
+        elapsed / std::chrono::duration<double>(config.budget.time_limit));
+    for (size_t slot = 0; slot < nreplicas; slot += 1) {
+      replicas[replica_of_slot[slot]].fix_temp(ladder[slot]);
+    }
+
+    pool.parallel_for(nreplicas, run_epochs);
+    for (const auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+    // Attempt exchanges between neighbouring slots, alternating between even
+    // and odd pairs
+    for (size_t slot = parity; slot + 1 < nreplicas; slot += 2) {
+      SimAnneal& cold = replicas[replica_of_slot[slot]];
+      SimAnneal& hot = replicas[replica_of_slot[slot + 1]];
+
+      const double exponent =
+          (1.0 / ladder[slot] - 1.0 / ladder[slot + 1]) *
+          narrow_cast<double>(cold.get_cost() - hot.get_cost());
+      nattempts[slot] += 1;
+      if (exponent < 0.0 && zero_one_gen(gen) > std::exp(exponent)) {
+        continue;
+      }
+
+      naccepts[slot] += 1;
+      std::swap(replica_of_slot[slot], replica_of_slot[slot + 1]);
+    }
+    parity ^= 1;
+  }
+  for (size_t replica_id = 0; replica_id < nreplicas; replica_id += 1) {
+    reporter.finish(replica_id);
+  }
+
+  for (size_t slot = 0; slot + 1 < nreplicas; slot += 1) {
+    fmt::print("Exchange between slots {} and {}: {} / {} accepted\n", slot,
+               slot + 1, naccepts[slot], nattempts[slot]);
+  }
+
+  const auto by_best_cost = [](const SimAnneal& a, const SimAnneal& b) {
+    return a.get_best_cost() < b.get_best_cost();
+  };
+  auto best = std::min_element(replicas.begin(), replicas.end(), by_best_cost);
+  fmt::print("Best replica ends at cost {}, best seen {} (gap {})\n",
+             best->get_cost(), best->get_best_cost(),
+             best->get_cost() - best->get_best_cost());
+  return best->into_best_blocks(inputs);
+}
@@ -0,0 +1,20 @@
+#ifndef TEMPERING_HPP_
+#define TEMPERING_HPP_
+
+#include "config.hpp"
+#include "cost.hpp"
+#include "data.hpp"
+
+#include <vector>
+
+// Optimizes `blocks` with parallel tempering until the time limit.
+// Replicas run concurrently at the temperatures of a geometric ladder, which
+// cools over the time limit like the schedule of SA, and neighbouring replicas
+// exchange temperatures by the Metropolis criterion after every epoch.
+// Returns the partition of the lowest cost among the replicas.
+std::vector<Block> perform_tempering_partition(const std::vector<Block>& blocks,
+                                               const InputData& inputs,
+                                               Cost init_cost,
+                                               const Config& config);
+
+#endif  // TEMPERING_HPP_
@@ -0,0 +1,69 @@
+#include "worker_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+WorkerPool::WorkerPool(size_t nthreads) {
+  for (size_t thread_id = 1; thread_id < nthreads; thread_id += 1) {
+    workers.emplace_back([this, thread_id] { work(thread_id); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex);
+    is_stopping = true;
+  }
+  start_cv.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void WorkerPool::parallel_for(size_t n,
+                              const std::function<void(size_t, size_t)>& f) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex);
+    task = &f;
+    task_size = n;
+    nbusy = workers.size();
+    generation += 1;
+  }
+  start_cv.notify_all();
+
+  run_chunk(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [this] { return nbusy == 0; });
+  task = nullptr;
+}
+
+void WorkerPool::work(size_t thread_id) {
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      start_cv.wait(lock, [&] {
+        return is_stopping || generation != seen_generation;
+      });
+      if (is_stopping) {
+        return;
+      }
+      seen_generation = generation;
+    }
+
+    run_chunk(thread_id);
+
+    bool is_last = false;
+    {
+      const std::lock_guard<std::mutex> lock(mutex);
+      nbusy -= 1;
+      is_last = nbusy == 0;
+    }
+    if (is_last) {
+      done_cv.notify_one();
+    }
+  }
+}
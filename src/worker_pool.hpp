@@ -0,0 +1,57 @@
+#ifndef WORKER_POOL_HPP_
+#define WORKER_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running data-parallel loops together with the calling
+// thread.
+class WorkerPool {
+ public:
+  // Starts `nthreads - 1` workers, so that `nthreads` threads take part in
+  // each loop including the caller.
+  explicit WorkerPool(size_t nthreads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Calls `f(begin, end)` on `size()` disjoint chunks covering [0, n), and
+  // returns once all of the calls are done.  `f` must not throw.
+  void parallel_for(size_t n, const std::function<void(size_t, size_t)>& f);
+
+  // Gets the number of threads taking part in each loop.
+  size_t size() const { return workers.size() + 1; }
+
+ private:
+  void work(size_t thread_id);
+
+  // Runs the chunk of thread `thread_id` of the current loop.
+  void run_chunk(size_t thread_id) const {
+    const size_t begin = task_size * thread_id / size();
+    const size_t end = task_size * (thread_id + 1) / size();
+    if (begin < end) {
+      (*task)(begin, end);
+    }
+  }
+
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+
+  // Current loop, published under `mutex` by bumping `generation`
+  const std::function<void(size_t, size_t)>* task = nullptr;
+  size_t task_size = 0;
+  uint64_t generation = 0;
+  size_t nbusy = 0;
+  bool is_stopping = false;
+};
+
+#endif  // WORKER_POOL_HPP_
@@ -0,0 +1,76 @@
+#include "cost.hpp"
+#include "data.hpp"
+#include "mapped_file.hpp"
+#include "worker_pool.hpp"
+
+#define FMT_HEADER_ONLY
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+// Verifies the partition written by `pa2` to OUTPUT for INPUT: that every cell
+// is in exactly one block, that no block exceeds the maximum block area, and
+// that the cost written matches the cost of the partition.  Prints a single
+// line of `key=value` fields, and exits with 1 if the partition fails any
+// check, or with 2 on bad usage.
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fmt::print(stderr, "Usage: {} INPUT OUTPUT\n", argv[0]);  // NOLINT
+    return 2;
+  }
+
+  const auto begin_time = steady_clock::now();
+  try {
+    const InputData inputs = InputData::read_from(string(argv[1]));  // NOLINT
+    const MappedFile output(argv[2]);                               // NOLINT
+    const BlocksFile blocks = parse_blocks(output.view(), inputs.ncells);
+
+    vector<size_t> block_areas(blocks.nblocks, 0);
+    for (CellId cell_id = 0; cell_id < inputs.ncells; cell_id += 1) {
+      block_areas[blocks.block_of_cell[cell_id]] += inputs.cell_areas[cell_id];
+    }
+    const size_t max_area =
+        block_areas.empty()
+            ? 0
+            : *std::max_element(block_areas.begin(), block_areas.end());
+    const auto noverfull = std::count_if(
+        block_areas.begin(), block_areas.end(),
+        [&](size_t area) { return area > inputs.max_block_area; });
+
+    WorkerPool pool{std::max(std::thread::hardware_concurrency(), 1U)};
+    const Cost cost =
+        find_cost(blocks.block_of_cell, blocks.nblocks, inputs, pool);
+
+    const bool is_cost_matched = cost == static_cast<Cost>(blocks.cost);
+    const char* status = "ok";
+    if (noverfull > 0) {
+      status = "overfull";
+    } else if (is_cost_matched == false) {
+      status = "cost_mismatch";
+    }
+
+    const std::chrono::duration<double> elapsed =
+        steady_clock::now() - begin_time;
+    fmt::print(
+        "status={} cost={} expected_cost={} cells={} nets={} blocks={} "
+        "max_area={} max_block_area={} overfull_blocks={} ms={:.1f}\n",
+        status, cost, blocks.cost, inputs.ncells, inputs.nnets, blocks.nblocks,
+        max_area, inputs.max_block_area, noverfull, elapsed.count() * 1e3);
+    return noverfull == 0 && is_cost_matched ? 0 : 1;
+  } catch (const std::exception& e) {
+    fmt::print("status=invalid\n");
+    fmt::print(stderr, "{}\n", e.what());
+    return 1;
+  }
+}